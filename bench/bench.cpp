@@ -0,0 +1,66 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "bench.hpp"
+
+#include <winapi/handle.hpp>
+#include <winapi/pipe.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bench {
+namespace {
+
+// Writes to a volatile can't be optimized away, so neither can whatever's
+// written.
+const void* volatile sink = nullptr;
+
+} // namespace
+
+std::vector<Case>& cases() {
+    static std::vector<Case> instance;
+    return instance;
+}
+
+Register::Register(std::string name, std::size_t nb, std::function<void()> iteration) {
+    cases().push_back({std::move(name), nb, std::move(iteration)});
+}
+
+void keep(const void* ptr) {
+    sink = ptr;
+}
+
+void drain_pipe(std::size_t nb, std::size_t pipe_size, const PipeReader& read) {
+    winapi::Pipe pipe{pipe_size};
+
+    std::thread writer{[&pipe, nb, pipe_size]() {
+        const std::vector<unsigned char> data(pipe_size, 'x');
+        try {
+            for (std::size_t offset = 0; offset < nb; offset += data.size())
+                pipe.write_end().write(data.data(), std::min(data.size(), nb - offset));
+        } catch (...) {
+            // The reader gave up.
+        }
+        pipe.write_end().close();
+    }};
+
+    try {
+        read(pipe.read_end());
+    } catch (...) {
+        // Unblock the writer.
+        pipe.read_end().close();
+        writer.join();
+        throw;
+    }
+    writer.join();
+}
+
+} // namespace bench
@@ -0,0 +1,51 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include <winapi/handle.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/**
+ * A single benchmark.
+ * Every iteration processes the same number of bytes, so that the throughput
+ * can be reported.
+ */
+struct Case {
+    std::string name;
+    std::size_t nb;
+    std::function<void()> iteration;
+};
+
+/** All the benchmarks registered so far. */
+std::vector<Case>& cases();
+
+/** Register a benchmark; define these at namespace scope. */
+class Register {
+public:
+    Register(std::string name, std::size_t nb, std::function<void()> iteration);
+};
+
+/** Keep the compiler from optimizing away the computation of `ptr`. */
+void keep(const void* ptr);
+
+/** Called with the read end of the pipe by drain_pipe(). */
+using PipeReader = std::function<void(const winapi::Handle&)>;
+
+/**
+ * Write some data into a pipe from another thread, and read it all.
+ * @param nb        Number of bytes to write.
+ * @param pipe_size Size of the pipe buffer.
+ * @param read      Must read until the write end is closed.
+ */
+void drain_pipe(std::size_t nb, std::size_t pipe_size, const PipeReader& read);
+
+} // namespace bench
@@ -0,0 +1,111 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+// Reading into a Buffer, which zero-fills whatever it grows by, vs. reading
+// into an UninitBuffer.
+
+#include "bench.hpp"
+
+#include <winapi/buffer.hpp>
+#include <winapi/handle.hpp>
+#include <winapi/uninit_buffer.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <format>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace winapi;
+
+namespace {
+
+constexpr std::size_t total_size = 64 * 1024 * 1024;
+
+// Stands in for ReadFile, without the syscall.
+void fake_read(void* dest, const std::vector<unsigned char>& src) {
+    std::memcpy(dest, src.data(), src.size());
+}
+
+void memory_zero_fill(std::size_t chunk_size) {
+    const std::vector<unsigned char> src(chunk_size, 'x');
+    Buffer buffer;
+    for (std::size_t offset = 0; offset < total_size; offset += chunk_size) {
+        buffer.clear();
+        buffer.resize(chunk_size);
+        fake_read(buffer.data(), src);
+    }
+    bench::keep(buffer.data());
+}
+
+void memory_uninit(std::size_t chunk_size) {
+    const std::vector<unsigned char> src(chunk_size, 'x');
+    UninitBuffer buffer;
+    for (std::size_t offset = 0; offset < total_size; offset += chunk_size) {
+        buffer.clear();
+        buffer.resize(chunk_size);
+        fake_read(buffer.data(), src);
+    }
+    bench::keep(buffer.data());
+}
+
+// This is what Handle::read_chunk used to do.
+void pipe_zero_fill(std::size_t chunk_size) {
+    bench::drain_pipe(total_size, chunk_size, [chunk_size](const Handle& handle) {
+        Buffer buffer;
+        bool next = true;
+        while (next) {
+            buffer.resize(chunk_size);
+            std::size_t nb_read = 0;
+            next = handle.read_chunk(buffer.data(), chunk_size, nb_read);
+            buffer.resize(nb_read);
+        }
+        bench::keep(buffer.data());
+    });
+}
+
+void pipe_read_chunk(std::size_t chunk_size) {
+    bench::drain_pipe(total_size, chunk_size, [chunk_size](const Handle& handle) {
+        auto policy = Handle::ChunkSize::fixed(chunk_size);
+        Buffer buffer;
+        bool next = true;
+        while (next)
+            next = handle.read_chunk(buffer, policy);
+        bench::keep(buffer.data());
+    });
+}
+
+std::string name(std::string_view what, std::size_t chunk_size) {
+    return std::format("buffer/{}/{}KiB", what, chunk_size / 1024);
+}
+
+const bench::Register memory_zero_fill_16k{
+    name("memory/zero_fill", 16 * 1024), total_size, [] { memory_zero_fill(16 * 1024); }
+};
+const bench::Register memory_uninit_16k{
+    name("memory/uninit", 16 * 1024), total_size, [] { memory_uninit(16 * 1024); }
+};
+const bench::Register memory_zero_fill_1m{
+    name("memory/zero_fill", 1024 * 1024), total_size, [] { memory_zero_fill(1024 * 1024); }
+};
+const bench::Register memory_uninit_1m{
+    name("memory/uninit", 1024 * 1024), total_size, [] { memory_uninit(1024 * 1024); }
+};
+
+const bench::Register pipe_zero_fill_16k{
+    name("pipe/zero_fill", 16 * 1024), total_size, [] { pipe_zero_fill(16 * 1024); }
+};
+const bench::Register pipe_read_chunk_16k{
+    name("pipe/read_chunk", 16 * 1024), total_size, [] { pipe_read_chunk(16 * 1024); }
+};
+const bench::Register pipe_zero_fill_1m{
+    name("pipe/zero_fill", 1024 * 1024), total_size, [] { pipe_zero_fill(1024 * 1024); }
+};
+const bench::Register pipe_read_chunk_1m{
+    name("pipe/read_chunk", 1024 * 1024), total_size, [] { pipe_read_chunk(1024 * 1024); }
+};
+
+} // namespace
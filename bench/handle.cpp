@@ -0,0 +1,108 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+// Reading pipes & files using different chunk size policies, to tune the
+// defaults in Handle::ChunkSize.
+
+#include "bench.hpp"
+
+#include <winapi/file.hpp>
+#include <winapi/handle.hpp>
+#include <winapi/path.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace winapi;
+
+namespace {
+
+constexpr std::size_t total_size = 64 * 1024 * 1024;
+
+// Both the default pipe buffer size & a large one.
+constexpr std::size_t small_pipe_size = 16 * 1024;
+constexpr std::size_t large_pipe_size = 1024 * 1024;
+
+void read_all(const Handle& handle, Handle::ChunkSize chunk_size) {
+    std::size_t total = 0;
+    handle.read_each(chunk_size, [&total](std::span<const unsigned char> chunk) {
+        total += chunk.size();
+    });
+    bench::keep(&total);
+}
+
+class TestFile {
+public:
+    TestFile() : m_path{"winapi-common-bench.bin"} {
+        const std::vector<unsigned char> data(large_pipe_size, 'x');
+        const auto file = File::open_w(m_path);
+        for (std::size_t offset = 0; offset < total_size; offset += data.size())
+            file.write(data.data(), data.size());
+    }
+
+    ~TestFile() {
+        try {
+            File::remove(m_path);
+        } catch (const std::exception& e) {
+            std::cerr << std::format("Couldn't remove file {}: {}\n", m_path.get(), e.what());
+        }
+    }
+
+    const CanonicalPath& path() const {
+        return m_path;
+    }
+
+private:
+    CanonicalPath m_path;
+
+    TestFile(const TestFile&) = delete;
+    TestFile& operator=(const TestFile&) = delete;
+};
+
+const TestFile& test_file() {
+    // Only created if any of the file benchmarks are run.
+    static const TestFile instance;
+    return instance;
+}
+
+void add(std::string name, Handle::ChunkSize chunk_size) {
+    for (const auto pipe_size : {small_pipe_size, large_pipe_size}) {
+        bench::cases().push_back({
+            std::format("handle/pipe/{}KiB/{}", pipe_size / 1024, name),
+            total_size,
+            [pipe_size, chunk_size]() {
+                bench::drain_pipe(total_size, pipe_size, [chunk_size](const Handle& handle) {
+                    read_all(handle, chunk_size);
+                });
+            },
+        });
+    }
+
+    bench::cases().push_back({
+        std::format("handle/file/{}", name),
+        total_size,
+        [chunk_size]() {
+            const auto file = File::open(test_file().path(), File::OpenOptions::read());
+            read_all(file, chunk_size);
+        },
+    });
+}
+
+struct Registrar {
+    Registrar() {
+        for (const std::size_t nb : {4, 16, 64, 256, 1024})
+            add(std::format("fixed/{}KiB", nb), Handle::ChunkSize::fixed(nb * 1024));
+        add("adaptive", Handle::ChunkSize::adaptive());
+    }
+};
+
+const Registrar registrar;
+
+} // namespace
@@ -0,0 +1,74 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+// Usage: winapi-common-benchmarks [FILTER...]
+// Runs every benchmark whose name contains one of the filters, or all of them.
+
+#include "bench.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Run every benchmark for at least this long.
+constexpr auto min_duration = std::chrono::seconds{1};
+constexpr std::size_t min_iterations = 3;
+
+bool matches(std::string_view name, const std::vector<std::string_view>& filters) {
+    if (filters.empty())
+        return true;
+    for (const auto filter : filters)
+        if (name.find(filter) != std::string_view::npos)
+            return true;
+    return false;
+}
+
+void run(const bench::Case& bench) {
+    // Warm up the caches & the allocator.
+    bench.iteration();
+
+    std::size_t iterations = 0;
+    const auto start = Clock::now();
+    auto elapsed = Clock::duration::zero();
+    while (iterations < min_iterations || elapsed < min_duration) {
+        bench.iteration();
+        ++iterations;
+        elapsed = Clock::now() - start;
+    }
+
+    const auto seconds = std::chrono::duration<double>{elapsed}.count();
+    const auto us_per_iteration = seconds * 1e6 / static_cast<double>(iterations);
+    const auto mib = static_cast<double>(bench.nb) * static_cast<double>(iterations) / 1048576.;
+    std::cout << std::format(
+        "{:<48} {:>8} iterations {:>12.1f} us {:>10.1f} MiB/s\n",
+        bench.name,
+        iterations,
+        us_per_iteration,
+        mib / seconds
+    );
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    try {
+        const std::vector<std::string_view> filters{argv + 1, argv + argc};
+        for (const auto& bench : bench::cases())
+            if (matches(bench.name, filters))
+                run(bench);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
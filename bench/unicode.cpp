@@ -0,0 +1,139 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+// UTF-8 <-> UTF-16 conversion: the vectorized ASCII fast path vs. the generic
+// routines from winapi-utf8.
+
+#include "bench.hpp"
+
+#include "unicode.hpp"
+
+#include <winapi/utf8.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace winapi;
+
+namespace {
+
+// Every iteration converts about this much data, however long the strings.
+constexpr std::size_t iteration_size = 1024 * 1024;
+
+std::size_t repeat_count(std::size_t nch) {
+    return std::max<std::size_t>(1, iteration_size / nch);
+}
+
+// A typical path, or a huge command line.
+constexpr std::size_t path_length = 200;
+constexpr std::size_t cmd_line_length = 32 * 1024;
+
+std::string make_ascii(std::size_t nch) {
+    std::string result;
+    result.reserve(nch);
+    for (std::size_t i = 0; i < nch; ++i)
+        result.push_back(static_cast<char>('a' + i % 26));
+    return result;
+}
+
+// ASCII, except for a single character in the middle.
+std::string make_mixed(std::size_t nch) {
+    auto result = make_ascii(nch);
+    result.replace(nch / 2, 2, "\xc3\xbc");
+    return result;
+}
+
+void add(std::string name, std::size_t nb, std::function<void()> iteration) {
+    bench::cases().push_back({std::move(name), nb, std::move(iteration)});
+}
+
+template <typename Fn>
+void add_widen(std::string_view impl, std::string_view input, std::string src, Fn fn) {
+    const auto repeat = repeat_count(src.size());
+    const auto nb = src.size() * repeat;
+    auto name = std::format("unicode/widen/{}/{}/{}", input, src.size(), impl);
+    add(std::move(name), nb, [src = std::move(src), repeat, fn]() {
+        for (std::size_t i = 0; i < repeat; ++i) {
+            const auto dest = fn(src);
+            bench::keep(dest.data());
+        }
+    });
+}
+
+template <typename Fn>
+void add_narrow(std::string_view impl, std::string_view input, std::string_view utf8, Fn fn) {
+    auto src = unicode::widen(utf8);
+    const auto repeat = repeat_count(src.size());
+    const auto nb = src.size() * sizeof(wchar_t) * repeat;
+    auto name = std::format("unicode/narrow/{}/{}/{}", input, src.size(), impl);
+    add(std::move(name), nb, [src = std::move(src), repeat, fn]() {
+        for (std::size_t i = 0; i < repeat; ++i) {
+            const auto dest = fn(src);
+            bench::keep(dest.data());
+        }
+    });
+}
+
+void add_kernel(std::string_view impl, unicode::Kernel kernel) {
+    if (!unicode::is_supported(kernel))
+        return;
+
+    const auto nch = cmd_line_length;
+    const auto repeat = repeat_count(nch);
+
+    auto ascii = make_ascii(nch);
+    auto name = std::format("unicode/widen_ascii/{}", impl);
+    add(std::move(name), nch * repeat, [kernel, src = std::move(ascii), nch, repeat]() {
+        std::vector<std::uint16_t> dest(nch);
+        for (std::size_t i = 0; i < repeat; ++i)
+            unicode::widen_ascii(kernel, src.data(), nch, dest.data());
+        bench::keep(dest.data());
+    });
+
+    const auto nb = nch * sizeof(std::uint16_t) * repeat;
+    std::vector<std::uint16_t> wide(nch, 'a');
+    name = std::format("unicode/narrow_ascii/{}", impl);
+    add(std::move(name), nb, [kernel, src = std::move(wide), nch, repeat]() {
+        std::string dest(nch, '\0');
+        for (std::size_t i = 0; i < repeat; ++i)
+            unicode::narrow_ascii(kernel, src.data(), nch, dest.data());
+        bench::keep(dest.data());
+    });
+}
+
+struct Registrar {
+    Registrar() {
+        for (const auto nch : {path_length, cmd_line_length}) {
+            for (const auto& [input, src] : {
+                     std::pair{"ascii", make_ascii(nch)},
+                     std::pair{"mixed", make_mixed(nch)},
+                 }) {
+                const auto generic_widen = [](std::string_view s) { return winapi::widen(s); };
+                const auto fast_widen = [](std::string_view s) { return unicode::widen(s); };
+                const auto generic_narrow = [](std::wstring_view s) { return winapi::narrow(s); };
+                const auto fast_narrow = [](std::wstring_view s) { return unicode::narrow(s); };
+                add_widen("generic", input, src, generic_widen);
+                add_widen("fast", input, src, fast_widen);
+                add_narrow("generic", input, src, generic_narrow);
+                add_narrow("fast", input, src, fast_narrow);
+            }
+        }
+
+        add_kernel("scalar", unicode::Kernel::Scalar);
+        add_kernel("sse2", unicode::Kernel::SSE2);
+        add_kernel("avx2", unicode::Kernel::AVX2);
+    }
+};
+
+const Registrar registrar;
+
+} // namespace
@@ -0,0 +1,78 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace winapi {
+
+/**
+ * @brief Fixed-size buffer for unbuffered file I/O.
+ *
+ * Files opened with File::OpenOptions::no_buffering() can only be read into
+ * & written from sector-aligned buffers, in multiples of the sector size.
+ * This buffer is allocated at a page boundary, which is aligned to any
+ * sector size up to a page, and its size is a multiple of `alignment`.
+ */
+class AlignedBuffer {
+public:
+    /** Alignment of the data & granularity of the size. */
+    static constexpr std::size_t alignment = 4096;
+
+    /**
+     * Round a number of bytes up to a multiple of another number.
+     * @param nb       Number of bytes.
+     * @param multiple Sector size, see File::get_sector_size().
+     */
+    static std::size_t round_up(std::size_t nb, std::size_t multiple = alignment);
+
+    /** Create an empty buffer. */
+    AlignedBuffer() = default;
+
+    /**
+     * Allocate a buffer.
+     * @param nb Minimum number of bytes, rounded up to a multiple of `alignment`.
+     */
+    explicit AlignedBuffer(std::size_t nb);
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept
+        : m_data{std::move(other.m_data)}, m_size{std::exchange(other.m_size, 0)} {}
+
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+        m_data = std::move(other.m_data);
+        m_size = std::exchange(other.m_size, 0);
+        return *this;
+    }
+
+    unsigned char* data() const {
+        return m_data.get();
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    std::span<unsigned char> get() const {
+        return {data(), size()};
+    }
+
+private:
+    struct Free {
+        void operator()(unsigned char*) const;
+    };
+
+    std::unique_ptr<unsigned char, Free> m_data;
+    std::size_t m_size = 0;
+};
+
+} // namespace winapi
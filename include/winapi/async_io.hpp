@@ -0,0 +1,129 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include "buffer.hpp"
+#include "handle.hpp"
+#include "io_stats.hpp"
+
+#include <windows.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace winapi {
+
+/**
+ * @brief Overlapped I/O operation in progress.
+ *
+ * Returned by Handle::async_read() & Handle::async_write().
+ * The handle must have been opened for overlapped I/O (e.g. using
+ * File::open_r_async()), and must outlive the operation.
+ * If the operation is still in progress when this object is destroyed, it's
+ * cancelled, and the destructor waits for the cancellation to complete.
+ * The event of every operation is taken from a process-wide pool & put back
+ * once the operation's state is freed, so that starting an operation doesn't
+ * require creating a new event.
+ */
+class AsyncIo {
+public:
+    /** Start reading at most `nb` bytes at offset `offset`. */
+    static AsyncIo read(HANDLE handle, std::size_t nb, std::uint64_t offset = 0);
+    /** Start writing the contents of `buffer` at offset `offset`. */
+    static AsyncIo write(HANDLE handle, Buffer buffer, std::uint64_t offset = 0);
+
+    AsyncIo(AsyncIo&&) noexcept = default;
+    AsyncIo& operator=(AsyncIo&& other) noexcept;
+    ~AsyncIo();
+
+    /** Check if the operation has completed, without blocking. */
+    bool is_ready() const;
+
+    /**
+     * Wait for the operation to complete.
+     * @return Number of bytes transferred.
+     */
+    std::size_t wait();
+
+    /**
+     * Wait for the operation to complete, with a timeout.
+     * @return `true` if the operation has completed, `false` on timeout.
+     */
+    bool wait_for(std::chrono::milliseconds timeout);
+
+    /**
+     * Cancel the operation, if it's still in progress.
+     * Waits for the operation to complete, even if the cancellation fails.
+     */
+    void cancel();
+
+    /** Number of bytes transferred, valid after the operation's completed. */
+    std::size_t get_size() const;
+
+    /** Check if a read has hit the end of the file or a closed pipe. */
+    bool is_eof() const;
+
+    /**
+     * Data read or written.
+     * After a read completes, it's resized to the number of bytes read.
+     * Don't touch this while the operation is in progress.
+     */
+    Buffer& buffer() {
+        return m_state->buffer;
+    }
+
+    const Buffer& buffer() const {
+        return m_state->buffer;
+    }
+
+    /** Event signalled when the operation completes. */
+    HANDLE event() const {
+        return m_state->event.get();
+    }
+
+    /** The operation's OVERLAPPED structure, for completion ports. */
+    OVERLAPPED* overlapped() const {
+        return &m_state->overlapped;
+    }
+
+private:
+    struct State {
+        State(HANDLE handle, std::uint64_t offset);
+        ~State();
+
+        State(const State&) = delete;
+        State& operator=(const State&) = delete;
+
+        OVERLAPPED overlapped;
+        HANDLE handle;
+        Handle event;
+        Buffer buffer;
+        bool reading = false;
+        bool done = false;
+        bool eof = false;
+        std::size_t nb = 0;
+#ifdef WINAPI_COMMON_IO_STATS
+        IoStats::Clock::time_point start;
+#endif
+    };
+
+    explicit AsyncIo(std::unique_ptr<State> state) : m_state{std::move(state)} {}
+
+    void abandon() noexcept;
+    void started(const char* function);
+    void complete(bool block);
+    // Counts the completed operation in IoStats::global(), if enabled.
+    void record() const;
+    bool wait_until_done() noexcept;
+
+    // The OVERLAPPED structure & the buffer must stay in place while the
+    // operation's in progress, even if this object is moved.
+    std::unique_ptr<State> m_state;
+};
+
+} // namespace winapi
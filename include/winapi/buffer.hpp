@@ -6,12 +6,15 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <format>
 #include <initializer_list>
+#include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -34,6 +37,9 @@ public:
     /** Construct a buffer from an instance of `std::vector<unsigned char>`. */
     explicit Buffer(Parent&& src) : Parent{std::move(src)} {}
 
+    /** Construct a buffer from a copy of `std::vector<unsigned char>`. */
+    explicit Buffer(const Parent& src) : Parent{src} {}
+
     /** Construct a buffer from a string view. */
     template <typename CharT>
     explicit Buffer(std::basic_string_view<CharT> src) {
@@ -48,38 +54,81 @@ public:
     /** Replace the buffer's contents with the data from a string view. */
     template <typename CharT>
     void set(std::basic_string_view<CharT> src) {
-        set(src.data(), src.length() * sizeof(std::basic_string_view<CharT>::char_type));
+        set(src.data(), src.length() * sizeof(CharT));
     }
 
     /** Replace the buffer's contents with the data from a memory region. */
     void set(const void* src, std::size_t nb) {
-        resize(nb);
-        std::memcpy(data(), src, nb);
+        const auto bytes = static_cast<const unsigned char*>(src);
+        // Unlike resize(), this doesn't zero-fill the bytes first.
+        assign(bytes, bytes + nb);
     }
 
     /** Interpret the buffer's contents as a `std::string`. */
     std::string as_utf8() const {
+        return std::string{as_utf8_view()};
+    }
+
+    /** Interpret the buffer's contents as a `std::wstring`. */
+    std::wstring as_utf16() const {
+        return std::wstring{as_utf16_view()};
+    }
+
+    /**
+     * Interpret the buffer's contents as a UTF-8 string without copying.
+     * The view is invalidated when the buffer is modified or destroyed.
+     */
+    std::string_view as_utf8_view() const& {
         const auto c_str = reinterpret_cast<const char*>(data());
         const auto nb = size();
         const auto nch = nb;
         return {c_str, nch};
     }
+    void as_utf8_view() const&& = delete;
 
-    /** Interpret the buffer's contents as a `std::wstring`. */
-    std::wstring as_utf16() const {
-        const auto c_str = reinterpret_cast<const wchar_t*>(data());
+    /**
+     * Interpret the buffer's contents as a UTF-16 string without copying.
+     * The view is invalidated when the buffer is modified or destroyed.
+     */
+    std::wstring_view as_utf16_view() const& {
         const auto nb = size();
-        if (nb % 2 != 0)
+        if (nb % sizeof(wchar_t) != 0)
             throw std::runtime_error{std::format("Buffer size invalid at {} bytes", nb)};
-        const auto nch = nb / 2;
-        return {c_str, nch};
+        const auto span = as_span<wchar_t>();
+        return {span.data(), span.size()};
+    }
+    void as_utf16_view() const&& = delete;
+
+    /**
+     * Interpret the buffer's contents as an array of records without copying.
+     * The view is invalidated when the buffer is modified or destroyed.
+     */
+    template <typename T>
+    std::span<const T> as_span() const& {
+        static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+        const auto nb = size();
+        if (nb % sizeof(T) != 0)
+            throw std::runtime_error{
+                std::format("Buffer size {} is not a multiple of {}", nb, sizeof(T))
+            };
+        if (reinterpret_cast<std::uintptr_t>(data()) % alignof(T) != 0)
+            throw std::runtime_error{
+                std::format("Buffer data is not aligned at {} bytes", alignof(T))
+            };
+        return {reinterpret_cast<const T*>(data()), nb / sizeof(T)};
     }
+    template <typename T>
+    void as_span() const&& = delete;
 
     /** Append another buffer to the end of this one. */
     void add(const Buffer& src) {
-        const auto nb = size();
-        resize(nb + src.size());
-        std::memcpy(data() + nb, src.data(), src.size());
+        add(src.data(), src.size());
+    }
+
+    /** Append the data from a memory region to the end of this buffer. */
+    void add(const void* src, std::size_t nb) {
+        const auto bytes = static_cast<const unsigned char*>(src);
+        insert(end(), bytes, bytes + nb);
     }
 };
 
@@ -0,0 +1,168 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include "buffer.hpp"
+#include "chunked_buffer.hpp"
+#include "handle.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace winapi {
+
+class BufferPool;
+
+/**
+ * @brief Buffer borrowed from a BufferPool.
+ *
+ * The buffer is returned to the pool when this object is destroyed.
+ */
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+
+    PooledBuffer(PooledBuffer&& other) noexcept
+        : m_pool{std::exchange(other.m_pool, nullptr)}, m_buffer{std::move(other.m_buffer)} {}
+
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_pool = std::exchange(other.m_pool, nullptr);
+            m_buffer = std::move(other.m_buffer);
+        }
+        return *this;
+    }
+
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    ~PooledBuffer() {
+        reset();
+    }
+
+    /** Check if this object holds a buffer borrowed from a pool. */
+    bool is_borrowed() const {
+        return m_pool != nullptr;
+    }
+
+    Buffer& get() {
+        return m_buffer;
+    }
+
+    const Buffer& get() const {
+        return m_buffer;
+    }
+
+    Buffer& operator*() {
+        return get();
+    }
+
+    const Buffer& operator*() const {
+        return get();
+    }
+
+    Buffer* operator->() {
+        return &m_buffer;
+    }
+
+    const Buffer* operator->() const {
+        return &m_buffer;
+    }
+
+    /** Return the buffer to the pool. */
+    void reset();
+
+private:
+    friend class BufferPool;
+
+    PooledBuffer(BufferPool& pool, Buffer&& buffer) : m_pool{&pool}, m_buffer{std::move(buffer)} {}
+
+    BufferPool* m_pool = nullptr;
+    Buffer m_buffer;
+};
+
+/**
+ * @brief Thread-safe pool of fixed-size buffers.
+ *
+ * Lets Handle reuse its read buffers instead of allocating a new one for
+ * every chunk.
+ * Each thread keeps a small cache of free buffers for each of the last few
+ * pools it used, so that borrowing & returning a buffer on the same thread
+ * doesn't require locking.
+ * A thread frees the buffers it cached for a pool when it notices that the
+ * pool has been destroyed, or when it exits.
+ */
+class BufferPool {
+public:
+    static constexpr std::size_t default_max_free = 64;
+    static constexpr std::size_t thread_cache_size = 8;
+    static constexpr std::size_t thread_cache_pools = 4;
+
+    /**
+     * Create an empty pool.
+     * @param chunk_size Capacity of each buffer in the pool.
+     * @param max_free   Maximum number of free buffers shared between threads.
+     */
+    explicit BufferPool(
+        std::size_t chunk_size = Handle::max_chunk_size,
+        std::size_t max_free = default_max_free
+    );
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /** Capacity of each buffer in the pool. */
+    std::size_t chunk_size() const {
+        return m_chunk_size;
+    }
+
+    /**
+     * Take an empty buffer out of the pool.
+     * The buffer has at least chunk_size() bytes of capacity.
+     */
+    Buffer acquire();
+
+    /** Borrow an empty buffer, which is returned automatically. */
+    PooledBuffer borrow() {
+        return {*this, acquire()};
+    }
+
+    /**
+     * Put a buffer back into the pool.
+     * Buffers that have any capacity other than chunk_size() are simply freed.
+     */
+    void release(Buffer&& buffer);
+
+    /** Put every chunk of a ChunkedBuffer back into the pool. */
+    void release(ChunkedBuffer&& buffer) {
+        for (auto& chunk : buffer.release())
+            release(std::move(chunk));
+    }
+
+private:
+    const std::uint64_t m_id;
+    // Lets the threads tell if the pool is still alive.
+    const std::shared_ptr<const void> m_alive;
+    const std::size_t m_chunk_size;
+    const std::size_t m_max_free;
+
+    std::mutex m_mtx;
+    std::vector<Buffer> m_free;
+};
+
+inline void PooledBuffer::reset() {
+    if (m_pool) {
+        std::exchange(m_pool, nullptr)->release(std::move(m_buffer));
+        m_buffer = Buffer{};
+    }
+}
+
+} // namespace winapi
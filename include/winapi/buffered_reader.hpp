@@ -0,0 +1,71 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include "handle.hpp"
+#include "uninit_buffer.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+namespace winapi {
+
+/**
+ * @brief Reads a Handle line by line.
+ *
+ * Lines are returned as soon as they've been read, so that output can be
+ * processed while it's being produced, in constant memory (unless the lines
+ * themselves are huge).
+ * The handle must outlive the reader.
+ */
+class BufferedReader {
+public:
+    /**
+     * Wrap a handle.
+     * @param handle     Handle to read from.
+     * @param chunk_size Maximum number of bytes to read at once.
+     */
+    explicit BufferedReader(const Handle& handle, std::size_t chunk_size = Handle::max_chunk_size);
+
+    BufferedReader(const BufferedReader&) = delete;
+    BufferedReader& operator=(const BufferedReader&) = delete;
+
+    /**
+     * Read the next line.
+     * Both `\n` & `\r\n` are recognized as line terminators; the terminator
+     * is not included.
+     * A `\r` at the very end of the input isn't a terminator, and is kept.
+     * @return View into the internal buffer, valid until the next call, or
+     *         nothing if there are no more lines.
+     */
+    std::optional<std::string_view> read_line();
+
+    /**
+     * Call a function for each of the remaining lines.
+     * @param callback Called with a `std::string_view` for each line.
+     */
+    template <typename Callback>
+    void for_each_line(Callback&& callback) {
+        while (const auto line = read_line())
+            callback(*line);
+    }
+
+private:
+    bool fill();
+
+    const Handle& m_handle;
+    const std::size_t m_chunk_size;
+    UninitBuffer m_buffer;
+    // Data before m_begin has already been returned.
+    std::size_t m_begin = 0;
+    // There's no line terminator between m_begin and m_scanned.
+    std::size_t m_scanned = 0;
+    bool m_eof = false;
+};
+
+} // namespace winapi
@@ -0,0 +1,99 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include "buffer.hpp"
+#include "handle.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace winapi {
+
+/**
+ * @brief Batches small writes to a Handle.
+ *
+ * Data is accumulated in a buffer, which is written to the handle when it's
+ * full, when flush() is called, or when the writer is destroyed.
+ * Writes that wouldn't fit into the buffer anyway go to the handle directly,
+ * without being copied.
+ * The handle must outlive the writer.
+ */
+class BufferedWriter {
+public:
+    static constexpr std::size_t default_buffer_size = 64 * 1024;
+
+    /**
+     * Wrap a handle.
+     * @param handle      Handle to write to.
+     * @param buffer_size Number of bytes to accumulate before writing.
+     */
+    explicit BufferedWriter(const Handle& handle, std::size_t buffer_size = default_buffer_size);
+
+    /** Flushes the buffer, ignoring errors; call flush() to handle them. */
+    ~BufferedWriter();
+
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    std::size_t buffer_size() const {
+        return m_buffer_size;
+    }
+
+    /** Number of bytes waiting to be written. */
+    std::size_t buffered() const {
+        return m_buffer.size();
+    }
+
+    /**
+     * Write data.
+     * @param data Pointer to binary data.
+     * @param nb   Data size.
+     */
+    void write(const void* data, std::size_t nb);
+    /**
+     * Write data.
+     * @param buffer Binary data to write.
+     */
+    void write(const Buffer& buffer) {
+        write(buffer.data(), buffer.size());
+    }
+    /**
+     * Write data.
+     * @param src Binary data to write.
+     */
+    template <typename CharT>
+    void write(std::basic_string_view<CharT> src) {
+        write(src.data(), src.length() * sizeof(CharT));
+    }
+    /**
+     * Write data.
+     * @param src Binary data to write.
+     */
+    template <
+        typename CharT,
+        typename Traits = std::char_traits<CharT>,
+        typename Allocator = std::allocator<CharT>>
+    void write(const std::basic_string<CharT, Traits, Allocator>& src) {
+        write(std::basic_string_view<CharT>{src});
+    }
+
+    /**
+     * Write the buffered data to the handle.
+     * Partial writes are retried; if the handle stops accepting data, the
+     * data that hasn't been written stays in the buffer.
+     */
+    void flush();
+
+private:
+    const Handle& m_handle;
+    const std::size_t m_buffer_size;
+    Buffer m_buffer;
+};
+
+} // namespace winapi
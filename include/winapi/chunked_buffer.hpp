@@ -0,0 +1,155 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include "buffer.hpp"
+
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace winapi {
+
+/**
+ * @brief Segmented binary data container.
+ *
+ * This class stores a blob of binary data as a list of separately allocated
+ * chunks.
+ * Appending a chunk never touches the data that's already been stored, so
+ * growing the container doesn't cause any reallocations or copying.
+ */
+class ChunkedBuffer {
+public:
+    using Chunk = Buffer;
+    using Chunks = std::vector<Chunk>;
+    using View = std::span<const unsigned char>;
+
+    /** @brief Iterates over views of individual chunks. */
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = View;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = View;
+
+        Iterator() = default;
+
+        View operator*() const {
+            return View{m_it->data(), m_it->size()};
+        }
+
+        Iterator& operator++() {
+            ++m_it;
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            auto prev = *this;
+            ++m_it;
+            return prev;
+        }
+
+        bool operator==(const Iterator& other) const = default;
+
+    private:
+        friend class ChunkedBuffer;
+
+        explicit Iterator(Chunks::const_iterator it) : m_it{it} {}
+
+        Chunks::const_iterator m_it;
+    };
+
+    ChunkedBuffer() = default;
+
+    /** Append a chunk, taking ownership of its memory. */
+    void add(Chunk&& chunk) {
+        if (chunk.empty())
+            return;
+        m_size += chunk.size();
+        m_chunks.emplace_back(std::move(chunk));
+    }
+
+    /** Append a copy of a memory region as a new chunk. */
+    void add(const void* src, std::size_t nb) {
+        if (nb == 0)
+            return;
+        add(Chunk{src, nb});
+    }
+
+    /** Total number of bytes stored. */
+    std::size_t size() const {
+        return m_size;
+    }
+
+    /** Check if there's no data stored. */
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    /** Number of chunks stored. */
+    std::size_t chunk_count() const {
+        return m_chunks.size();
+    }
+
+    /** Get a view of the i-th chunk. */
+    View chunk(std::size_t i) const {
+        const auto& src = m_chunks.at(i);
+        return View{src.data(), src.size()};
+    }
+
+    Iterator begin() const {
+        return Iterator{m_chunks.cbegin()};
+    }
+
+    Iterator end() const {
+        return Iterator{m_chunks.cend()};
+    }
+
+    /**
+     * Copy the data into a contiguous memory region.
+     * @param dest Must be at least size() bytes long.
+     */
+    void copy_to(void* dest) const {
+        auto dest_bytes = static_cast<unsigned char*>(dest);
+        for (const auto& view : *this) {
+            std::memcpy(dest_bytes, view.data(), view.size());
+            dest_bytes += view.size();
+        }
+    }
+
+    /** Copy the data into a single contiguous Buffer. */
+    Buffer flatten() const {
+        if (m_chunks.size() == 1)
+            return m_chunks.front();
+        Buffer buffer;
+        buffer.reserve(m_size);
+        for (const auto& view : *this)
+            buffer.insert(buffer.end(), view.begin(), view.end());
+        return buffer;
+    }
+
+    /** Take the stored chunks out of this container, leaving it empty. */
+    Chunks release() {
+        m_size = 0;
+        return std::exchange(m_chunks, {});
+    }
+
+    /** Remove all the stored data. */
+    void clear() {
+        m_chunks.clear();
+        m_size = 0;
+    }
+
+private:
+    Chunks m_chunks;
+    std::size_t m_size = 0;
+};
+
+} // namespace winapi
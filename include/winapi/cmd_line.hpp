@@ -29,6 +29,11 @@ public:
      * @param src UTF-8 encoded string.
      */
     static CommandLine parse(std::string_view src);
+    /**
+     * Parse a command line from a string.
+     * @param src UTF-16 encoded string.
+     */
+    static CommandLine parse(std::wstring_view src);
 
     /**
      * Build a command line from main() arguments.
@@ -48,16 +53,14 @@ public:
      * @param argv0 UTF-8 string, argv[0].
      * @param args  List of UTF-8 strings, other arguments.
      */
-    explicit CommandLine(const std::string& argv0, const std::vector<std::string>& args = {})
-        : m_argv0{argv0}, m_args{args} {}
+    explicit CommandLine(const std::string& argv0, const std::vector<std::string>& args = {});
 
     /**
      * Build a command line.
      * @param argv0 UTF-8 string, argv[0].
      * @param args  List of UTF-8 strings, other arguments.
      */
-    explicit CommandLine(std::string&& argv0, std::vector<std::string>&& args = {})
-        : m_argv0{std::move(argv0)}, m_args{std::move(args)} {}
+    explicit CommandLine(std::string&& argv0, std::vector<std::string>&& args = {});
 
     /**
      * Build a command line.
@@ -65,7 +68,22 @@ public:
      */
     explicit CommandLine(std::vector<std::string> argv);
 
+    /**
+     * Build a command line.
+     * @param argv0 UTF-16 string, argv[0].
+     * @param args  List of UTF-16 strings, other arguments.
+     */
+    explicit CommandLine(const std::wstring& argv0, const std::vector<std::wstring>& args = {});
+
+    /**
+     * Build a command line.
+     * @param argv List of UTF-16 strings, including argv[0].
+     */
+    explicit CommandLine(std::vector<std::wstring> argv);
+
     static std::string escape(std::string_view);
+    /** @overload */
+    static std::wstring escape(std::wstring_view);
 
     static std::string escape_cmd(std::string_view);
 
@@ -81,6 +99,18 @@ public:
      */
     std::string args_to_string() const;
 
+    /**
+     * Build a string that represents this command line.
+     * @return UTF-16 string, suitable for passing to CreateProcessW.
+     */
+    std::wstring to_wstring() const;
+
+    /**
+     * Build a string that represents this command line, but omit argv[0].
+     * @return UTF-16 string.
+     */
+    std::wstring args_to_wstring() const;
+
     /**
      * Get argv[0] for this command line.
      * @return UTF-8 string.
@@ -108,6 +138,22 @@ public:
      */
     std::vector<std::string> get_argv() const;
 
+    /**
+     * Get argv[0] for this command line.
+     * @return UTF-16 string.
+     */
+    const std::wstring& get_wargv0() const {
+        return m_wargv0;
+    }
+
+    /**
+     * Get list of arguments for this command line beyond argv[0].
+     * @return List of UTF-16 strings.
+     */
+    const std::vector<std::wstring>& get_wargs() const {
+        return m_wargs;
+    }
+
 private:
     static constexpr char token_sep() {
         return ' ';
@@ -121,8 +167,12 @@ private:
 
     std::vector<std::string> escape_argv() const;
 
+    // Both UTF-8 and UTF-16 versions are stored, so that launching a process
+    // doesn't require converting the arguments every time.
     std::string m_argv0;
     std::vector<std::string> m_args;
+    std::wstring m_wargv0;
+    std::vector<std::wstring> m_wargs;
 };
 
 } // namespace winapi
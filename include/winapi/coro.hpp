@@ -0,0 +1,385 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+/**
+ * @file
+ * @brief C++20 coroutine support.
+ *
+ * Overlapped I/O operations & processes can be co_await-ed.
+ * A suspended coroutine doesn't occupy a thread: it's resumed on a Windows
+ * thread pool thread once the object it waits for is signalled.
+ */
+
+#pragma once
+
+#include "async_io.hpp"
+#include "buffer.hpp"
+
+#include <windows.h>
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace winapi {
+
+class IoCompletionPort;
+class Process;
+
+namespace coro {
+
+/**
+ * @brief Suspends a coroutine until a handle is signalled.
+ *
+ * The coroutine is resumed on a thread pool thread.
+ */
+class WaitAwaiter {
+public:
+    explicit WaitAwaiter(HANDLE handle) : m_handle{handle} {}
+
+    WaitAwaiter(const WaitAwaiter&) = delete;
+    WaitAwaiter& operator=(const WaitAwaiter&) = delete;
+
+    /** Check if the handle's already signalled. */
+    bool await_ready() const;
+    bool await_suspend(std::coroutine_handle<> coroutine);
+    void await_resume();
+
+private:
+    static void CALLBACK on_signalled(PVOID context, BOOLEAN timed_out);
+
+    HANDLE m_handle;
+    HANDLE m_wait = NULL;
+    std::coroutine_handle<> m_coroutine;
+    // Both the thread that registers the wait & the callback set this; the
+    // one to do it second resumes the coroutine.
+    std::atomic<bool> m_registered{false};
+};
+
+/**
+ * @brief Waits for an overlapped I/O operation.
+ * @return Number of bytes transferred.
+ */
+class IoAwaiter : public WaitAwaiter {
+public:
+    explicit IoAwaiter(AsyncIo& io) : WaitAwaiter{io.event()}, m_io{io} {}
+
+    bool await_ready() const {
+        return m_io.is_ready();
+    }
+
+    std::size_t await_resume() {
+        WaitAwaiter::await_resume();
+        return m_io.wait();
+    }
+
+private:
+    AsyncIo& m_io;
+};
+
+/**
+ * @brief Overlapped read of a single chunk, returned by Handle::async_read_chunk().
+ * @return Data read, empty at the end of the file or a closed pipe.
+ */
+class ReadChunk : public WaitAwaiter {
+public:
+    explicit ReadChunk(AsyncIo&& io) : WaitAwaiter{io.event()}, m_io{std::move(io)} {}
+
+    bool await_ready() const {
+        return m_io.is_ready();
+    }
+
+    Buffer await_resume() {
+        WaitAwaiter::await_resume();
+        m_io.wait();
+        return std::move(m_io.buffer());
+    }
+
+private:
+    AsyncIo m_io;
+};
+
+/**
+ * @brief Waits for a process to terminate, returned by Process::exited().
+ * @return The process's exit code.
+ */
+class ProcessExit : public WaitAwaiter {
+public:
+    explicit ProcessExit(const Process& process);
+
+    int await_resume();
+
+private:
+    const Process& m_process;
+};
+
+/** @brief Resumes a coroutine on one of the completion port's workers. */
+class Schedule {
+public:
+    explicit Schedule(IoCompletionPort& port) : m_port{port} {}
+
+    bool await_ready() const {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> coroutine);
+
+    void await_resume() const {}
+
+private:
+    IoCompletionPort& m_port;
+};
+
+/** `co_await schedule(port)` moves the coroutine to the port's workers. */
+inline Schedule schedule(IoCompletionPort& port) {
+    return Schedule{port};
+}
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+class TaskPromiseBase {
+public:
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> coroutine) noexcept {
+            const auto continuation = coroutine.promise().continuation();
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+
+    void unhandled_exception() {
+        m_exception = std::current_exception();
+    }
+
+    std::coroutine_handle<> continuation() const {
+        return m_continuation;
+    }
+
+    void set_continuation(std::coroutine_handle<> continuation) {
+        m_continuation = continuation;
+    }
+
+protected:
+    void rethrow_if_failed() const {
+        if (m_exception)
+            std::rethrow_exception(m_exception);
+    }
+
+private:
+    std::coroutine_handle<> m_continuation;
+    std::exception_ptr m_exception;
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    Task<T> get_return_object();
+
+    template <typename U>
+    void return_value(U&& value) {
+        m_value.emplace(std::forward<U>(value));
+    }
+
+    T result() {
+        rethrow_if_failed();
+        return std::move(*m_value);
+    }
+
+private:
+    std::optional<T> m_value;
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    Task<void> get_return_object();
+
+    void return_void() const {}
+
+    void result() const {
+        rethrow_if_failed();
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Lazily started coroutine, which produces a value of type T.
+ *
+ * The coroutine starts when the task is co_await-ed, and the awaiting
+ * coroutine is resumed when the task finishes.
+ * Use sync_wait() or spawn() to run a task from regular code.
+ */
+template <typename T>
+class Task {
+public:
+    using promise_type = detail::TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task(Task&& other) noexcept : m_coroutine{std::exchange(other.m_coroutine, {})} {}
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            m_coroutine = std::exchange(other.m_coroutine, {});
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        destroy();
+    }
+
+    auto operator co_await() noexcept {
+        struct Awaiter {
+            bool await_ready() const noexcept {
+                return m_coroutine.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept {
+                m_coroutine.promise().set_continuation(continuation);
+                return m_coroutine;
+            }
+
+            T await_resume() {
+                return m_coroutine.promise().result();
+            }
+
+            Handle m_coroutine;
+        };
+
+        return Awaiter{m_coroutine};
+    }
+
+private:
+    friend promise_type;
+
+    explicit Task(Handle coroutine) : m_coroutine{coroutine} {}
+
+    void destroy() {
+        if (m_coroutine)
+            std::exchange(m_coroutine, {}).destroy();
+    }
+
+    Handle m_coroutine;
+};
+
+namespace detail {
+
+template <typename T>
+Task<T> TaskPromise<T>::get_return_object() {
+    return Task<T>{Task<T>::Handle::from_promise(*this)};
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+    return Task<void>{Task<void>::Handle::from_promise(*this)};
+}
+
+// Starts immediately & destroys itself when done.
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() const {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() const noexcept {
+            return {};
+        }
+
+        std::suspend_never final_suspend() const noexcept {
+            return {};
+        }
+
+        void return_void() const {}
+
+        void unhandled_exception() const {
+            std::terminate();
+        }
+    };
+};
+
+// Both the task & the promise are owned by this coroutine's frame: the waiting
+// thread may return from sync_wait() as soon as the result is set, while the
+// rest of this coroutine is still running on another thread.
+// Setting the result only touches the state shared with the future.
+template <typename T>
+Detached run_and_notify(Task<T> task, std::promise<T> result) {
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            result.set_value();
+        } else {
+            result.set_value(co_await task);
+        }
+    } catch (...) {
+        result.set_exception(std::current_exception());
+    }
+}
+
+inline Detached run_detached(Task<void> task) {
+    co_await task;
+}
+
+} // namespace detail
+
+/**
+ * Run a task, blocking the calling thread until it finishes.
+ * @return The task's result; exceptions are propagated.
+ */
+template <typename T>
+T sync_wait(Task<T> task) {
+    std::promise<T> result;
+    auto future = result.get_future();
+    detail::run_and_notify(std::move(task), std::move(result));
+    return future.get();
+}
+
+/**
+ * Start a task without waiting for it to finish.
+ * The task runs on this thread until it first suspends.
+ * Exceptions escaping the task terminate the program.
+ */
+inline void spawn(Task<void> task) {
+    detail::run_detached(std::move(task));
+}
+
+} // namespace coro
+
+// These must be found by argument-dependent lookup, hence the namespace.
+
+inline coro::IoAwaiter operator co_await(AsyncIo& io) {
+    return coro::IoAwaiter{io};
+}
+
+inline coro::IoAwaiter operator co_await(AsyncIo&& io) {
+    return coro::IoAwaiter{io};
+}
+
+} // namespace winapi
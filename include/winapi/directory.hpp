@@ -0,0 +1,188 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include "buffer.hpp"
+#include "file.hpp"
+#include "path.hpp"
+
+#include <windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace winapi {
+
+/** @brief Directory entry, as returned by DirectoryIterator. */
+struct DirEntry {
+    /** UTF-16 name of the entry, without the directory path. */
+    std::wstring name;
+    /** FILE_ATTRIBUTE_* flags. */
+    DWORD attributes = 0;
+    /** File size, bytes. */
+    std::uint64_t size = 0;
+    /** Timestamps, in 100-nanosecond intervals since January 1, 1601 (UTC). */
+    std::int64_t creation_time = 0;
+    std::int64_t last_access_time = 0;
+    std::int64_t last_write_time = 0;
+    /**
+     * File ID.
+     * Only the lower 64 bits of the ID are reported by the file system.
+     * On NTFS, that matches File::query_id(); elsewhere, it might not be
+     * unique (FAT reports 0 for every file, and ReFS IDs don't fit).
+     */
+    File::ID id;
+
+    /** @return UTF-8 name of the entry. */
+    std::string get_name() const;
+
+    bool is_directory() const {
+        return (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+    }
+
+    /** Symbolic links, junctions, etc. */
+    bool is_reparse_point() const {
+        return (attributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0;
+    }
+};
+
+/**
+ * @brief Enumerates the entries of a directory.
+ *
+ * The entries are read in large batches, and their metadata comes with
+ * them, without opening every file.
+ * The "." & ".." entries are skipped.
+ */
+class DirectoryIterator {
+public:
+    /** Default size of the buffer for batches of entries. */
+    static constexpr std::size_t default_buffer_size = 64 * 1024;
+
+    /** Open a directory. */
+    static DirectoryIterator open(std::string_view, std::size_t buffer_size = default_buffer_size);
+    /** @overload */
+    static DirectoryIterator open(
+        std::wstring_view, std::size_t buffer_size = default_buffer_size
+    );
+    /** @overload */
+    static DirectoryIterator open(
+        const CanonicalPath&, std::size_t buffer_size = default_buffer_size
+    );
+
+    /**
+     * Make an iterator from an open directory handle.
+     * @param dir         Directory opened using File::OpenOptions::list_directory().
+     * @param buffer_size Size of the buffer for batches of entries.
+     */
+    explicit DirectoryIterator(File&& dir, std::size_t buffer_size = default_buffer_size);
+
+    /**
+     * Make an iterator from an open directory handle, if the serial number
+     * of its volume is already known.
+     * This saves a File::query_id() call when enumerating many directories
+     * on the same volume.
+     * @param dir         Directory opened using File::OpenOptions::list_directory().
+     * @param volume      Serial number of the volume, as in File::ID.
+     * @param buffer_size Size of the buffer for batches of entries.
+     */
+    DirectoryIterator(File&& dir, ULONGLONG volume, std::size_t buffer_size = default_buffer_size);
+
+    /**
+     * Read the next entry.
+     * @return The entry, or an empty value after the last one.
+     */
+    std::optional<DirEntry> next();
+
+    /** Call a function for every remaining entry. */
+    template <typename Fn>
+    void for_each(Fn&& fn) {
+        while (auto entry = next())
+            fn(*entry);
+    }
+
+private:
+    bool fill();
+
+    File m_dir;
+    ULONGLONG m_volume;
+    Buffer m_buffer;
+    // Offset of the next entry in the buffer, or SIZE_MAX if the buffer's
+    // exhausted.
+    std::size_t m_offset = 0;
+    bool m_started = false;
+    bool m_finished = false;
+};
+
+/**
+ * @brief Walks a directory tree using multiple threads.
+ *
+ * Every subdirectory is enumerated by one of the worker threads.
+ * Files with multiple hard links are reported once, on file systems with
+ * unique file IDs (like NTFS).
+ * Symbolic links & junctions are reported, but not followed, so the walk
+ * never leaves the volume of the root directory.
+ */
+class DirectoryWalker {
+public:
+    /**
+     * Called for every entry.
+     * Called concurrently on the worker threads.
+     * @param dir   Path to the directory, which contains the entry.
+     * @param entry The entry.
+     */
+    using Callback = std::function<void(const std::wstring& dir, const DirEntry& entry)>;
+
+    /**
+     * Called when a directory can't be enumerated, e.g. if access is denied.
+     * Called concurrently on the worker threads.
+     * Return to skip the directory (whatever's been reported from it is
+     * kept), or throw to stop the walk.
+     * @param dir   Path to the directory.
+     * @param error The error.
+     */
+    using ErrorCallback =
+        std::function<void(const std::wstring& dir, const std::system_error& error)>;
+
+    /** Number of worker threads used by default: one per CPU core. */
+    static std::size_t default_thread_count();
+
+    /** @param thread_count Number of worker threads. */
+    explicit DirectoryWalker(std::size_t thread_count = default_thread_count());
+
+    /**
+     * Walk a directory tree, blocking until every entry is reported.
+     * If a callback throws, the walk is stopped & the first exception is
+     * rethrown.
+     * If the root directory can't be opened, that's rethrown right away.
+     * If any other directory can't be enumerated, `on_error` is called; if
+     * it's empty, the walk is stopped & the error is rethrown.
+     */
+    void walk(
+        std::string_view root, const Callback& callback, const ErrorCallback& on_error = {}
+    ) const;
+    /** @overload */
+    void walk(
+        std::wstring_view root, const Callback& callback, const ErrorCallback& on_error = {}
+    ) const;
+    /** @overload */
+    void walk(
+        const CanonicalPath& root, const Callback& callback, const ErrorCallback& on_error = {}
+    ) const;
+
+private:
+    void walk_impl(
+        std::wstring root, const Callback& callback, const ErrorCallback& on_error
+    ) const;
+
+    std::size_t m_thread_count;
+};
+
+} // namespace winapi
@@ -5,22 +5,72 @@
 
 #pragma once
 
+#include "buffer.hpp"
 #include "handle.hpp"
 #include "path.hpp"
+#include "shmem.hpp"
 
 #include <boost/functional/hash.hpp>
 
 #include <windows.h>
 
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <span>
+#include <string>
 #include <string_view>
 #include <utility>
+#include <vector>
 
 namespace winapi {
 
 bool operator==(const FILE_ID_128& a, const FILE_ID_128& b);
 
+/** @brief Progress of File::copy(). */
+struct FileCopyProgress {
+    /** Number of bytes copied so far. */
+    std::uint64_t copied = 0;
+    /** Size of the source file, bytes. */
+    std::uint64_t total = 0;
+    /** Time since the copy has started. */
+    std::chrono::steady_clock::duration elapsed{};
+
+    /** @return Average throughput, bytes per second. */
+    double get_throughput() const;
+};
+
+/** @brief Options for File::copy(). */
+struct FileCopyOptions {
+    /** When to bypass the system cache. */
+    enum class Unbuffered {
+        Never,
+        Always,
+        /** For files larger than the physical memory. */
+        Auto,
+    };
+
+    /** Size of every read & write, bytes. */
+    std::size_t chunk_size = 4 * 1024 * 1024;
+    /**
+     * Number of chunks being copied at the same time.
+     * Values above MAXIMUM_WAIT_OBJECTS are treated as MAXIMUM_WAIT_OBJECTS.
+     */
+    std::size_t queue_depth = 4;
+    Unbuffered unbuffered = Unbuffered::Auto;
+    /**
+     * Extend the destination file using File::set_size_fast().
+     * If the copy fails, the file may then contain stale data from the
+     * disk.
+     */
+    bool skip_zero_fill = false;
+    /** Called on the calling thread periodically & once the copy is done. */
+    std::function<void(const FileCopyProgress&)> on_progress;
+    /** How often on_progress is called. */
+    std::chrono::milliseconds progress_interval{100};
+};
+
 /**
  * @brief File I/O.
  *
@@ -37,22 +87,275 @@ public:
         }
     };
 
+    /**
+     * @brief How to open a file, see File::open().
+     *
+     * Start with read(), read_attributes() or write() & adjust the defaults:
+     * `File::OpenOptions::read().sequential_scan()`.
+     */
+    class OpenOptions {
+    public:
+        /** Open an existing file for reading; others can read it too. */
+        static OpenOptions read();
+        /** Open an existing file to read its attributes; others can read & write it. */
+        static OpenOptions read_attributes();
+        /** Open or create a file for writing; others can read it. */
+        static OpenOptions write();
+        /** Open a directory to enumerate its entries, see DirectoryIterator. */
+        static OpenOptions list_directory();
+
+        /** Hint that the file is going to be read from start to end. */
+        OpenOptions& sequential_scan() {
+            m_flags = (m_flags & ~FILE_FLAG_RANDOM_ACCESS) | FILE_FLAG_SEQUENTIAL_SCAN;
+            return *this;
+        }
+
+        /** Hint that the file is going to be accessed at random offsets. */
+        OpenOptions& random_access() {
+            m_flags = (m_flags & ~FILE_FLAG_SEQUENTIAL_SCAN) | FILE_FLAG_RANDOM_ACCESS;
+            return *this;
+        }
+
+        /** Don't return from writes until the data reaches the disk. */
+        OpenOptions& write_through() {
+            m_flags |= FILE_FLAG_WRITE_THROUGH;
+            return *this;
+        }
+
+        /**
+         * Bypass the system cache.
+         * Offsets & sizes of reads & writes must then be multiples of the
+         * sector size, and the buffers must be aligned; use AlignedBuffer.
+         */
+        OpenOptions& no_buffering() {
+            m_flags |= FILE_FLAG_NO_BUFFERING;
+            return *this;
+        }
+
+        /** Hint that the file is short-lived & should be kept in memory if possible. */
+        OpenOptions& temporary() {
+            m_attributes |= FILE_ATTRIBUTE_TEMPORARY;
+            return *this;
+        }
+
+        /**
+         * Delete the file once every handle to it is closed.
+         * Also lets others open the file for deletion, since they'd fail
+         * otherwise.
+         */
+        OpenOptions& delete_on_close() {
+            m_flags |= FILE_FLAG_DELETE_ON_CLOSE;
+            return share_delete();
+        }
+
+        /** Open the file for overlapped I/O, see Handle::async_read(). */
+        OpenOptions& overlapped() {
+            m_flags |= FILE_FLAG_OVERLAPPED;
+            return *this;
+        }
+
+        /** Let others open the file for reading. */
+        OpenOptions& share_read(bool share = true) {
+            return set_share_mode(FILE_SHARE_READ, share);
+        }
+
+        /** Let others open the file for writing. */
+        OpenOptions& share_write(bool share = true) {
+            return set_share_mode(FILE_SHARE_WRITE, share);
+        }
+
+        /** Let others delete or rename the file. */
+        OpenOptions& share_delete(bool share = true) {
+            return set_share_mode(FILE_SHARE_DELETE, share);
+        }
+
+        /** Let child processes inherit the handle (the default). */
+        OpenOptions& inheritable(bool inherit = true) {
+            m_inheritable = inherit;
+            return *this;
+        }
+
+        DWORD get_access() const {
+            return m_access;
+        }
+
+        DWORD get_share_mode() const {
+            return m_share_mode;
+        }
+
+        DWORD get_creation_disposition() const {
+            return m_disposition;
+        }
+
+        /** FILE_FLAG_* flags, without the attributes, as ReOpenFile expects them. */
+        DWORD get_flags() const {
+            return m_flags;
+        }
+
+        /** Value of the `dwFlagsAndAttributes` parameter of CreateFile. */
+        DWORD get_flags_and_attributes() const {
+            return m_flags | (m_attributes == 0 ? FILE_ATTRIBUTE_NORMAL : m_attributes);
+        }
+
+        bool is_inheritable() const {
+            return m_inheritable;
+        }
+
+    private:
+        OpenOptions(DWORD access, DWORD share_mode, DWORD disposition)
+            : m_access{access}, m_share_mode{share_mode}, m_disposition{disposition} {}
+
+        OpenOptions& set_share_mode(DWORD mode, bool share) {
+            if (share)
+                m_share_mode |= mode;
+            else
+                m_share_mode &= ~mode;
+            return *this;
+        }
+
+        DWORD m_access;
+        DWORD m_share_mode;
+        DWORD m_disposition;
+        DWORD m_flags = 0;
+        // FILE_ATTRIBUTE_NORMAL is only valid on its own.
+        DWORD m_attributes = 0;
+        bool m_inheritable = true;
+    };
+
+    /**
+     * @brief Metadata of many files, see stat_many().
+     *
+     * The i-th element of every array describes the i-th path.
+     */
+    struct Stats {
+        /** ERROR_SUCCESS, or the reason the file couldn't be queried. */
+        std::vector<DWORD> errors;
+        /** FILE_ATTRIBUTE_* flags. */
+        std::vector<DWORD> attributes;
+        /** File sizes, bytes. */
+        std::vector<std::uint64_t> sizes;
+        /** In 100-nanosecond intervals since January 1, 1601 (UTC). */
+        std::vector<std::int64_t> last_write_times;
+
+        std::size_t size() const {
+            return errors.size();
+        }
+
+        bool is_ok(std::size_t i) const {
+            return errors[i] == ERROR_SUCCESS;
+        }
+    };
+
+    /** Number of threads used by read_all_parallel() & others by default: one per CPU core. */
+    static std::size_t default_thread_count();
+
+    /** Number of threads used by stat_many() by default, see default_thread_count(). */
+    static std::size_t default_stat_thread_count();
+
+    /**
+     * Query the size, attributes & modification time of many files.
+     * No file is opened; the queries are spread across a few threads.
+     * Errors are reported per file instead of being thrown.
+     * @param paths        UTF-8 paths.
+     * @param thread_count Maximum number of threads.
+     */
+    static Stats stat_many(
+        std::span<const std::string> paths, std::size_t thread_count = default_stat_thread_count()
+    );
+    /** @overload */
+    static Stats stat_many(
+        std::span<const std::wstring> paths, std::size_t thread_count = default_stat_thread_count()
+    );
+    /** @overload */
+    static Stats stat_many(
+        std::span<const CanonicalPath> paths,
+        std::size_t thread_count = default_stat_thread_count()
+    );
+
+    using CopyProgress = FileCopyProgress;
+    using CopyOptions = FileCopyOptions;
+
+    /**
+     * Copy a file.
+     * The destination is preallocated, then the chunks of the source are
+     * read & written using overlapped I/O, with up to queue_depth reads &
+     * writes in flight at the same time.
+     * The destination is created or overwritten.
+     * @return Final progress, with the total time & throughput.
+     */
+    static CopyProgress copy(
+        std::string_view src, std::string_view dst, const CopyOptions& options = {}
+    );
+    /** @overload */
+    static CopyProgress copy(
+        std::wstring_view src, std::wstring_view dst, const CopyOptions& options = {}
+    );
+    /** @overload */
+    static CopyProgress copy(
+        const CanonicalPath& src, const CanonicalPath& dst, const CopyOptions& options = {}
+    );
+
+    /** Open file. */
+    static File open(std::string_view, const OpenOptions&);
+    /** @overload */
+    static File open(std::wstring_view, const OpenOptions&);
+    /** @overload */
+    static File open(const CanonicalPath&, const OpenOptions&);
+
     /** Open file for reading. */
     static File open_r(std::string_view);
     /** @overload */
+    static File open_r(std::wstring_view);
+    /** @overload */
     static File open_r(const CanonicalPath&);
     /** Open file for reading (inc. ability to read its attributes). */
     static File open_read_attributes(std::string_view);
     /** @overload */
+    static File open_read_attributes(std::wstring_view);
+    /** @overload */
     static File open_read_attributes(const CanonicalPath&);
     /** Open file for writing. */
     static File open_w(std::string_view);
     /** @overload */
+    static File open_w(std::wstring_view);
+    /** @overload */
     static File open_w(const CanonicalPath&);
 
+    /**
+     * Open file for overlapped reading.
+     * Use Handle::async_read() with such files; reads must specify an
+     * offset, since overlapped handles don't maintain the file position.
+     */
+    static File open_r_async(std::string_view);
+    /** @overload */
+    static File open_r_async(std::wstring_view);
+    /** @overload */
+    static File open_r_async(const CanonicalPath&);
+    /**
+     * Open file for overlapped writing.
+     * Use Handle::async_write() with such files.
+     */
+    static File open_w_async(std::string_view);
+    /** @overload */
+    static File open_w_async(std::wstring_view);
+    /** @overload */
+    static File open_w_async(const CanonicalPath&);
+
+    /**
+     * Map a file into memory for reading.
+     * The file is closed right away, the view remains valid.
+     */
+    static MappedView map_r(std::string_view);
+    /** @overload */
+    static MappedView map_r(std::wstring_view);
+    /** @overload */
+    static MappedView map_r(const CanonicalPath&);
+
     /** Delete a file. */
     static void remove(std::string_view);
     /** @overload */
+    static void remove(std::wstring_view);
+    /** @overload */
     static void remove(const CanonicalPath&);
 
     /** Make a File instance from an open handle. */
@@ -64,6 +367,110 @@ public:
      */
     std::size_t get_size() const;
 
+    /**
+     * Preallocate disk space for the file without changing its size.
+     * Writing up to `nb` bytes then doesn't grow the file piecemeal, which
+     * reduces fragmentation.
+     * @param nb Number of bytes.
+     */
+    void reserve(std::uint64_t nb) const;
+
+    /**
+     * Truncate or extend the file.
+     * The extended part reads as zeros.
+     * @param nb New file size, bytes.
+     */
+    void set_size(std::uint64_t nb) const;
+
+    /**
+     * Extend the file without zeroing the new part on disk.
+     * This requires SeManageVolumePrivilege, which is enabled if the process
+     * token holds it.
+     * The extended part then contains whatever was on disk before, so the
+     * whole file must be overwritten by the caller.
+     * If the file isn't extended, this is the same as set_size().
+     * @param nb New file size, bytes.
+     * @return true if the file was extended without zeroing, false if the
+     *         privilege isn't held or the file isn't extended, in which case
+     *         set_size() was used instead.
+     */
+    bool set_size_fast(std::uint64_t nb) const;
+
+    /**
+     * Mark the file as sparse (or not).
+     * Zeroed ranges of a sparse file take no disk space, see zero_range().
+     */
+    void set_sparse(bool sparse = true) const;
+
+    /**
+     * Fill a range of the file with zeros.
+     * In sparse files, the disk space of the range is freed.
+     * @param offset Offset of the range.
+     * @param nb     Number of bytes.
+     */
+    void zero_range(std::uint64_t offset, std::uint64_t nb) const;
+
+    /**
+     * Read everything from the current position to the end of the file.
+     * Unlike Handle::read(), this allocates the buffer once, using the file
+     * size as a hint, and reads it using a few large reads.
+     */
+    Buffer read_all() const;
+
+    /**
+     * Read from an offset.
+     * Can be called concurrently from multiple threads.
+     * If the file is opened for overlapped I/O (see OpenOptions::overlapped()),
+     * concurrent calls run in parallel & the file position isn't used.
+     * Otherwise, Windows runs them one at a time & moves the file position
+     * past the bytes read, so don't mix this with read() & write() then.
+     * @param offset Offset to read at.
+     * @param dest   Receives the data.
+     * @return Number of bytes read, less than requested only at the end of
+     *         the file.
+     */
+    std::size_t read_at(std::uint64_t offset, std::span<unsigned char> dest) const;
+
+    /**
+     * Write at an offset.
+     * Can be called concurrently from multiple threads, with the same caveats
+     * as read_at(): only overlapped handles let the writes run in parallel
+     * without moving the file position.
+     * @param offset Offset to write at.
+     * @param src    Data to write.
+     */
+    void write_at(std::uint64_t offset, std::span<const unsigned char> src) const;
+
+    /**
+     * Read the whole file, splitting it into parts read by multiple threads.
+     * Unlike read_all(), this always starts at the beginning of the file.
+     * The parts are read using a new overlapped handle to the same file, so
+     * that the reads run in parallel & the file position stays where it is.
+     * If the file can't be reopened (e.g. if somebody's opened it without
+     * sharing reads), this handle is used, see read_at().
+     * @param thread_count Maximum number of threads.
+     */
+    Buffer read_all_parallel(std::size_t thread_count = default_thread_count()) const;
+
+    /**
+     * Map the whole file into memory for reading.
+     * The file must be opened for reading; unlike read_all(), this doesn't
+     * copy the data.
+     */
+    MappedView map_r() const;
+    /**
+     * Map a range of the file into memory for reading.
+     * @param offset Offset of the range.
+     * @param nb     Number of bytes, the range must be inside the file.
+     */
+    MappedView map_r(std::uint64_t offset, std::size_t nb) const;
+
+    /**
+     * Get the sector size of the disk the file is on.
+     * Unbuffered I/O must be done in multiples of this size.
+     */
+    std::size_t get_sector_size() const;
+
     /**
      * Get file ID.
      * File ID is a unique representation of a file, suitable for hashing.
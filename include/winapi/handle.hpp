@@ -6,16 +6,34 @@
 #pragma once
 
 #include "buffer.hpp"
+#include "chunked_buffer.hpp"
+#include "io_stats.hpp"
 
 #include <windows.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
 #include <string_view>
 #include <utility>
 
 namespace winapi {
 
+class AsyncIo;
+class BufferPool;
+class PooledBuffer;
+
+namespace coro {
+class ReadChunk;
+}
+
 /**
  * @brief HANDLE wrapper.
  *
@@ -24,9 +42,95 @@ namespace winapi {
  */
 class Handle {
 public:
+    static constexpr std::size_t max_chunk_size = 16 * 1024;
+    static constexpr std::size_t max_gather_size = 64 * 1024;
+
+    /**
+     * @brief Read chunk size policy.
+     *
+     * Either a fixed size, or an adaptive one, which grows while reads come
+     * back full and shrinks when they don't.
+     * Large chunks are best for bulk transfers, while small ones are better
+     * for interactive use.
+     */
+    class ChunkSize {
+    public:
+        // Compare against fixed sizes using the handle/ benchmarks.
+        static constexpr std::size_t default_min = 4 * 1024;
+        static constexpr std::size_t default_max = 1024 * 1024;
+
+        /** Always read chunks of the same size. */
+        static ChunkSize fixed(std::size_t nb) {
+            return {nb, nb, nb};
+        }
+
+        /** Start with the minimum size & adapt to how much data there is. */
+        static ChunkSize adaptive(std::size_t min = default_min, std::size_t max = default_max) {
+            return {min, min, max};
+        }
+
+        /** Size of the next read. */
+        std::size_t get() const {
+            return m_current;
+        }
+
+        /** Override the size of the next read, within the policy's bounds. */
+        void set(std::size_t nb) {
+            m_current = std::clamp(nb, m_min, m_max);
+        }
+
+        bool is_adaptive() const {
+            return m_min != m_max;
+        }
+
+        /**
+         * Adjust the size of the next read.
+         * @param nb      Number of bytes requested by the last read.
+         * @param nb_read Number of bytes the last read returned.
+         */
+        void update(std::size_t nb, std::size_t nb_read) {
+            if (nb_read == nb && nb != 0) {
+                if (m_current <= m_max / 2)
+                    m_current *= 2;
+                else
+                    m_current = m_max;
+            } else if (nb_read < m_current / 2) {
+                m_current = std::max(m_current / 2, m_min);
+            }
+        }
+
+    private:
+        ChunkSize(std::size_t min, std::size_t current, std::size_t max)
+            : m_min{min}, m_current{current}, m_max{max} {
+            if (m_min == 0 || m_min > m_max)
+                throw std::range_error{"Invalid read chunk size"};
+            if (m_max > std::numeric_limits<DWORD>::max())
+                throw std::range_error{"Read chunk size is too large"};
+        }
+
+        std::size_t m_min;
+        std::size_t m_current;
+        std::size_t m_max;
+    };
+
+    /** Called for each chunk read by read_each(). */
+    using ChunkCallback = std::function<void(std::span<const unsigned char>)>;
+
+    /** What kind of object a handle refers to. */
+    enum class Kind {
+        Disk,
+        Pipe,
+        Console,
+        Char,
+        Unknown,
+    };
+
     Handle() = default;
     explicit Handle(HANDLE);
 
+    Handle(Handle&& other) noexcept;
+    Handle& operator=(Handle&& other) noexcept;
+
     HANDLE get() const {
         return m_impl.get();
     }
@@ -54,16 +158,100 @@ public:
     /** Check if this is the stderr handle. */
     static Handle std_err();
 
+    /**
+     * Get the kind of object this handle refers to.
+     * It's queried once & cached; reads & text writes use it to pick the
+     * best strategy.
+     */
+    Kind kind() const;
+
+    /**
+     * Get the read chunk size policy used by this handle.
+     * An adaptive policy carries over between reads that use it, so its
+     * current size reflects the previous reads from this handle.
+     */
+    ChunkSize get_chunk_size() const;
+
+    /**
+     * Set the read chunk size policy used by this handle.
+     * Defaults to an adaptive size for disk files, and a fixed size of
+     * max_chunk_size bytes otherwise.
+     */
+    void set_chunk_size(ChunkSize chunk_size) {
+        m_chunk_size = chunk_size;
+        m_next_chunk_size = 0;
+    }
+
     /** Read everything from this handle. */
     Buffer read() const;
+    /**
+     * Read everything from this handle.
+     * @param chunk_size Overrides this handle's chunk size policy.
+     */
+    Buffer read(ChunkSize chunk_size) const;
+    /**
+     * Read everything from this handle.
+     * Unlike read(), this never moves the data that's already been read,
+     * which makes it suitable for collecting large outputs.
+     */
+    ChunkedBuffer read_chunked() const;
+    /**
+     * Read everything from this handle.
+     * @param chunk_size Overrides this handle's chunk size policy.
+     */
+    ChunkedBuffer read_chunked(ChunkSize chunk_size) const;
+    /**
+     * Read everything from this handle.
+     * @param pool Pool to take the chunks from.
+     * Give the chunks back using BufferPool::release() when you're done.
+     */
+    ChunkedBuffer read_chunked(BufferPool& pool) const;
+
+    /**
+     * Read everything from this handle, without accumulating it.
+     * A single buffer is reused for every chunk.
+     * @param callback Called for each chunk; the data is only valid during
+     *                 the call.
+     */
+    void read_each(const ChunkCallback& callback) const;
+    /**
+     * Read everything from this handle, without accumulating it.
+     * @param chunk_size Overrides this handle's chunk size policy.
+     * @param callback   Called for each chunk; the data is only valid during
+     *                   the call.
+     */
+    void read_each(ChunkSize chunk_size, const ChunkCallback& callback) const;
 
-    static constexpr std::size_t max_chunk_size = 16 * 1024;
     /**
      * Read a chunk from this handle.
+     * Uses this handle's chunk size policy, updating it after the read.
      * @param read_chunk Receives the data read.
      * @return `true` if there's more data, `false` otherwise.
      */
     bool read_chunk(Buffer& read_chunk) const;
+    /**
+     * Read a chunk from this handle.
+     * @param read_chunk Receives the data read.
+     * @param chunk_size Chunk size policy, updated after the read.
+     * @return `true` if there's more data, `false` otherwise.
+     */
+    bool read_chunk(Buffer& read_chunk, ChunkSize& chunk_size) const;
+    /**
+     * Read a chunk from this handle into a buffer borrowed from a pool.
+     * @param pool       Pool to borrow the buffer from, unless `read_chunk`
+     *                   already holds one.
+     * @param read_chunk Receives the data read.
+     * @return `true` if there's more data, `false` otherwise.
+     */
+    bool read_chunk(BufferPool& pool, PooledBuffer& read_chunk) const;
+    /**
+     * Read a chunk from this handle into a memory region.
+     * @param dest    Destination memory region.
+     * @param nb      Maximum number of bytes to read.
+     * @param nb_read Receives the number of bytes read.
+     * @return `true` if there's more data, `false` otherwise.
+     */
+    bool read_chunk(void* dest, std::size_t nb, std::size_t& nb_read) const;
 
     /**
      * Write data to this handle.
@@ -76,6 +264,22 @@ public:
      * @param buffer Binary data to write.
      */
     void write(const Buffer& buffer) const;
+    /**
+     * Write as much data as this handle accepts in a single call.
+     * This can be less than requested for non-blocking pipes, for example.
+     * @param data Pointer to binary data.
+     * @param nb   Data size.
+     * @return Number of bytes written.
+     */
+    std::size_t write_some(const void* data, std::size_t nb) const;
+    /**
+     * Write data to this handle, gathered from multiple pieces.
+     * Small pieces are coalesced into blocks of up to max_gather_size bytes,
+     * each written using a single system call.
+     * Large pieces are written directly, without copying.
+     * @param pieces Binary data to write, in order.
+     */
+    void write(std::span<const std::span<const std::byte>> pieces) const;
     /**
      * Write data to this handle.
      * @param src Binary data to write.
@@ -96,17 +300,109 @@ public:
         write(std::basic_string_view<CharT>{src});
     }
 
+    /**
+     * Write UTF-8 text to this handle.
+     * Text written to a console goes through WriteConsoleW, so that it's
+     * displayed correctly regardless of the console's code page.
+     * Anything else receives the bytes as they are, just like with write().
+     * @param src UTF-8 text, made up of complete characters.
+     */
+    void write_text(std::string_view src) const;
+
+    /**
+     * Start reading from this handle asynchronously.
+     * The handle must have been opened for overlapped I/O.
+     * @param nb     Maximum number of bytes to read.
+     * @param offset Offset to read at, ignored for pipes.
+     */
+    AsyncIo async_read(std::size_t nb = max_chunk_size, std::uint64_t offset = 0) const;
+    /**
+     * Start writing to this handle asynchronously.
+     * The handle must have been opened for overlapped I/O.
+     * @param buffer Binary data to write, owned by the operation.
+     * @param offset Offset to write at, ignored for pipes.
+     */
+    AsyncIo async_write(Buffer buffer, std::uint64_t offset = 0) const;
+    /**
+     * Read a chunk from this handle in a coroutine.
+     * `co_await handle.async_read_chunk()` returns the data read, which is
+     * empty at the end of the file or a closed pipe.
+     * The handle must have been opened for overlapped I/O.
+     * @param nb     Maximum number of bytes to read.
+     * @param offset Offset to read at, ignored for pipes.
+     */
+    coro::ReadChunk async_read_chunk(std::size_t nb = max_chunk_size, std::uint64_t offset = 0)
+        const;
+
+#ifdef WINAPI_COMMON_IO_STATS
+    /**
+     * Get the I/O statistics of this handle.
+     * Overlapped I/O (async_read(), async_write(), IoCompletionPort &
+     * File::copy()) is only counted in IoStats::global().
+     */
+    IoStats::Snapshot get_io_stats() const;
+#endif
+
     void inherit(bool yes = true) const;
     void dont_inherit() const {
         inherit(false);
     }
 
+protected:
+#ifdef WINAPI_COMMON_IO_STATS
+    /** Count a read in both this handle's & the global statistics. */
+    void record_read(std::size_t nb, std::size_t nb_read, IoStats::Clock::duration latency) const;
+    /** Count a write in both this handle's & the global statistics. */
+    void record_write(std::size_t nb, IoStats::Clock::duration latency) const;
+#endif
+
 private:
     struct Close {
         void operator()(HANDLE) const;
     };
 
+#ifdef WINAPI_COMMON_IO_STATS
+    // Most handles never see any I/O, so the statistics are only allocated on
+    // the first read or write.
+    class LazyIoStats {
+    public:
+        LazyIoStats() = default;
+
+        LazyIoStats(LazyIoStats&& other) noexcept : m_stats{other.m_stats.exchange(nullptr)} {}
+
+        LazyIoStats& operator=(LazyIoStats&& other) noexcept {
+            if (this != &other)
+                delete m_stats.exchange(other.m_stats.exchange(nullptr));
+            return *this;
+        }
+
+        ~LazyIoStats() {
+            delete m_stats.load();
+        }
+
+        const IoStats* get() const {
+            return m_stats.load();
+        }
+
+        IoStats& get_or_create();
+
+    private:
+        std::atomic<IoStats*> m_stats{nullptr};
+    };
+#endif
+
+    void save_chunk_size(const ChunkSize& chunk_size) const {
+        m_next_chunk_size = chunk_size.get();
+    }
+
     std::unique_ptr<void, Close> m_impl;
+    std::optional<ChunkSize> m_chunk_size;
+    // Where an adaptive policy left off, 0 if there were no reads yet.
+    mutable std::atomic<std::size_t> m_next_chunk_size{0};
+    mutable std::atomic<std::optional<Kind>> m_kind;
+#ifdef WINAPI_COMMON_IO_STATS
+    mutable LazyIoStats m_io_stats;
+#endif
 };
 
 } // namespace winapi
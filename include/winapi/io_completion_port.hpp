@@ -0,0 +1,180 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include "buffer.hpp"
+#include "handle.hpp"
+
+#include <windows.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace winapi {
+
+/**
+ * @brief I/O completion port with a pool of worker threads.
+ *
+ * Handles opened for overlapped I/O (see File::open_r_async() &
+ * Pipe::overlapped()) are associated with the port, after which reads &
+ * writes can be started on them.
+ * When an operation completes, its callback is called on one of the worker
+ * threads.
+ * This allows a few threads to serve any number of handles.
+ *
+ * An exception thrown by a callback or a task doesn't stop the worker; the
+ * first one is rethrown by stop().
+ * Starting a read, a write or a task after stop() throws std::runtime_error.
+ */
+class IoCompletionPort {
+public:
+    /** @brief Result of an I/O operation. */
+    struct Result {
+        /** Windows error code, ERROR_SUCCESS if the operation succeeded. */
+        DWORD error = ERROR_SUCCESS;
+        /** Number of bytes transferred. */
+        std::size_t nb = 0;
+        /** Data read (resized to `nb`) or written. */
+        Buffer buffer;
+
+        bool is_ok() const {
+            return error == ERROR_SUCCESS;
+        }
+
+        /** Check if a read has hit the end of the file or a closed pipe. */
+        bool is_eof() const {
+            return error == ERROR_HANDLE_EOF || error == ERROR_BROKEN_PIPE;
+        }
+    };
+
+    using Callback = std::function<void(Result)>;
+    using Task = std::function<void()>;
+
+    /** Number of worker threads used by default: one per CPU core. */
+    static std::size_t default_thread_count();
+
+    /**
+     * Create a completion port & start the worker threads.
+     * @param thread_count Number of worker threads.
+     */
+    explicit IoCompletionPort(std::size_t thread_count = default_thread_count());
+
+    /** Calls stop(). */
+    ~IoCompletionPort();
+
+    IoCompletionPort(const IoCompletionPort&) = delete;
+    IoCompletionPort& operator=(const IoCompletionPort&) = delete;
+
+    HANDLE get() const {
+        return m_port.get();
+    }
+
+    std::size_t thread_count() const {
+        return m_workers.size();
+    }
+
+    /**
+     * Associate a handle with this port.
+     * The handle must have been opened for overlapped I/O, and can only be
+     * associated with a single port.
+     */
+    void associate(const Handle& handle) const;
+
+    /**
+     * Start reading from a handle.
+     * @param handle   Associated handle.
+     * @param nb       Maximum number of bytes to read.
+     * @param callback Called with the result on a worker thread.
+     */
+    void async_read(const Handle& handle, std::size_t nb, Callback callback) {
+        async_read(handle, nb, 0, std::move(callback));
+    }
+    /**
+     * Start reading from a handle.
+     * @param handle   Associated handle.
+     * @param nb       Maximum number of bytes to read.
+     * @param offset   Offset to read at, ignored for pipes.
+     * @param callback Called with the result on a worker thread.
+     */
+    void async_read(const Handle& handle, std::size_t nb, std::uint64_t offset, Callback callback);
+
+    /**
+     * Start writing to a handle.
+     * @param handle   Associated handle.
+     * @param buffer   Binary data to write, owned by the operation.
+     * @param callback Called with the result on a worker thread.
+     */
+    void async_write(const Handle& handle, Buffer buffer, Callback callback) {
+        async_write(handle, std::move(buffer), 0, std::move(callback));
+    }
+    /**
+     * Start writing to a handle.
+     * @param handle   Associated handle.
+     * @param buffer   Binary data to write, owned by the operation.
+     * @param offset   Offset to write at, ignored for pipes.
+     * @param callback Called with the result on a worker thread.
+     */
+    void async_write(
+        const Handle& handle, Buffer buffer, std::uint64_t offset, Callback callback
+    );
+
+    /** Run a function on one of the worker threads. */
+    void post(Task task);
+
+    /** Number of operations & tasks that haven't completed yet. */
+    std::size_t pending() const {
+        return m_pending.load();
+    }
+
+    /**
+     * Stop the worker threads.
+     * Then cancels the operations still in flight & waits for them to
+     * complete, calling their callbacks on this thread.
+     * Cancelled operations complete with ERROR_OPERATION_ABORTED; this
+     * includes the operations started by those callbacks.
+     * Once this returns, no more reads, writes or tasks can be started.
+     * @throws std::runtime_error If called from a worker thread, which would
+     *                            deadlock.
+     * @throws Whatever the first failed callback or task threw.
+     */
+    void stop();
+
+private:
+    struct Operation;
+
+    void start(Operation* op, BOOL ret);
+    void queue(Operation* op, ULONG_PTR key);
+    bool run_once(DWORD timeout);
+    // Counts a completed read or write in IoStats::global(), if enabled.
+    static void record(const Operation& op, DWORD ec, DWORD nb);
+    void run();
+
+    // Counts a new operation or task, unless the port has been stopped.
+    void track(Operation* op);
+    void untrack(Operation* op);
+    void cancel_all();
+    void save_error(std::exception_ptr error);
+
+    Handle m_port;
+    std::atomic<std::size_t> m_pending{0};
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    // Reads & writes that have been started, but not yet dequeued.
+    std::unordered_set<Operation*> m_in_flight;
+    std::exception_ptr m_error;
+    bool m_stopped = false;
+};
+
+} // namespace winapi
@@ -0,0 +1,106 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace winapi {
+
+/**
+ * @brief Handle I/O statistics.
+ *
+ * Only collected if the library is built with the WINAPI_COMMON_IO_STATS
+ * CMake option; otherwise, nothing is recorded & Handle doesn't carry any
+ * statistics.
+ * Statistics are kept for each handle, and for the whole process.
+ * Reads & writes through Handle & File are counted in both.
+ * Overlapped I/O (AsyncIo & IoCompletionPort) & File::copy() only know the
+ * raw handles they use, so they're only counted for the whole process.
+ * Overlapped operations take from the moment they're started until their
+ * completion is noticed.
+ */
+class IoStats {
+public:
+#ifdef WINAPI_COMMON_IO_STATS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Number of latency histogram buckets.
+     * Bucket 0 counts operations that took less than 1us, bucket N counts
+     * operations that took [2^(N-1), 2^N) us; the last bucket counts
+     * everything slower.
+     */
+    static constexpr std::size_t numof_buckets = 32;
+
+    using Histogram = std::array<std::uint64_t, numof_buckets>;
+
+    /** @brief Point-in-time copy of the statistics. */
+    struct Snapshot {
+        std::uint64_t reads = 0;
+        std::uint64_t bytes_read = 0;
+        /** Number of reads that returned less data than requested. */
+        std::uint64_t short_reads = 0;
+        Histogram read_latency{};
+
+        std::uint64_t writes = 0;
+        std::uint64_t bytes_written = 0;
+        Histogram write_latency{};
+    };
+
+    /** Statistics for the whole process. */
+    static IoStats& global();
+
+    /** Bucket in which an operation with the given latency is counted. */
+    static std::size_t bucket(Clock::duration latency);
+
+    IoStats() = default;
+
+    IoStats(const IoStats&) = delete;
+    IoStats& operator=(const IoStats&) = delete;
+
+    /**
+     * Record a single read.
+     * @param nb      Number of bytes requested.
+     * @param nb_read Number of bytes read.
+     * @param latency How long the read took.
+     */
+    void record_read(std::size_t nb, std::size_t nb_read, Clock::duration latency);
+
+    /**
+     * Record a single write.
+     * @param nb      Number of bytes written.
+     * @param latency How long the write took.
+     */
+    void record_write(std::size_t nb, Clock::duration latency);
+
+    Snapshot snapshot() const;
+
+    void reset();
+
+private:
+    using Counter = std::atomic<std::uint64_t>;
+    using AtomicHistogram = std::array<Counter, numof_buckets>;
+
+    Counter m_reads{0};
+    Counter m_bytes_read{0};
+    Counter m_short_reads{0};
+    AtomicHistogram m_read_latency{};
+
+    Counter m_writes{0};
+    Counter m_bytes_written{0};
+    AtomicHistogram m_write_latency{};
+};
+
+} // namespace winapi
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 namespace winapi {
 
@@ -14,19 +15,32 @@ class CanonicalPath {
 public:
     /** Make an absolute, canonical path. */
     static std::string canonicalize(std::string_view);
+    /** @overload */
+    static std::wstring canonicalize(std::wstring_view);
 
-    explicit CanonicalPath(std::string_view);
+    /** @param path UTF-8 string. */
+    explicit CanonicalPath(std::string_view path);
+    /** @param path UTF-16 string. */
+    explicit CanonicalPath(std::wstring_view path);
 
+    /** @return UTF-8 string. */
     std::string get() const {
         return m_path;
     }
 
+    /** @return UTF-8 string. */
     std::string path() const {
         return get();
     }
 
+    /** @return UTF-16 string. */
+    const std::wstring& get_wide() const {
+        return m_wide_path;
+    }
+
 private:
     std::string m_path;
+    std::wstring m_wide_path;
 };
 
 } // namespace winapi
@@ -7,6 +7,7 @@
 
 #include "handle.hpp"
 
+#include <cstddef>
 #include <utility>
 
 namespace winapi {
@@ -14,8 +15,27 @@ namespace winapi {
 /** @brief Anonymous pipe wrapper. */
 class Pipe {
 public:
+    static constexpr std::size_t default_buffer_size = 16 * 1024;
+
     /** Create a new pipe. */
-    Pipe();
+    Pipe() : Pipe{default_buffer_size} {}
+
+    /**
+     * Create a new pipe.
+     * @param buffer_size Suggested size of the pipe's buffer, bytes.
+     *                    Larger buffers suit bulk transfers better.
+     */
+    explicit Pipe(std::size_t buffer_size);
+
+    /**
+     * Create a new pipe, the read end of which supports overlapped I/O.
+     * Anonymous pipes don't support overlapped I/O, so this creates a
+     * uniquely named pipe instead.
+     * The write end is a regular, synchronous handle, which can be passed to
+     * a child process.
+     * @param buffer_size Suggested size of the pipe's buffer, bytes.
+     */
+    static Pipe overlapped(std::size_t buffer_size = default_buffer_size);
 
     /** Get the read end of the pipe. */
     Handle& read_end() {
@@ -35,6 +55,9 @@ public:
     }
 
 private:
+    Pipe(Handle&& read_end, Handle&& write_end)
+        : m_read_end{std::move(read_end)}, m_write_end{std::move(write_end)} {}
+
     Handle m_read_end;
     Handle m_write_end;
 };
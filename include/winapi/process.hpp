@@ -19,6 +19,10 @@
 
 namespace winapi {
 
+namespace coro {
+class ProcessExit;
+}
+
 /** @brief Process parameters for Process::create(). */
 struct ProcessParameters {
     enum ConsoleCreationMode {
@@ -61,6 +65,17 @@ public:
     /** Create a new process using the given command line and IO settings. */
     static Process create(const CommandLine&, process::IO);
 
+    /**
+     * Run a process, streaming its stdout to a callback.
+     * The output is never accumulated in memory.
+     * @param cmd_line  Command line.
+     * @param on_stdout Called for each chunk of the process's stdout.
+     * @return The process's exit code.
+     */
+    static int read_each_stdout(
+        const CommandLine& cmd_line, const Handle::ChunkCallback& on_stdout
+    );
+
     /** Create a new shell process using ShellParameters. */
     static Process shell(const ShellParameters&);
     /** Create a new shell process using the given command line. */
@@ -96,6 +111,11 @@ public:
     bool is_running() const;
     /** Wait for the process to terminate. */
     void wait() const;
+    /**
+     * Wait for the process to terminate in a coroutine.
+     * `co_await process.exited()` returns the process's exit code.
+     */
+    coro::ProcessExit exited() const;
     /** Make this process terminate with an exit code. */
     void terminate(int ec = 0) const;
     /** Same as calling terminate() and wait(). */
@@ -27,6 +27,8 @@ struct Stdin : Stream {
     /** Make child process read form a file. */
     explicit Stdin(std::string_view file);
     /** @overload */
+    explicit Stdin(std::wstring_view file);
+    /** @overload */
     explicit Stdin(const CanonicalPath& file);
     /** Make child process read form a pipe. */
     explicit Stdin(Pipe&);
@@ -39,6 +41,8 @@ struct Stdout : Stream {
     /** Redirect child process's stdout to a file. */
     explicit Stdout(std::string_view file);
     /** @overload */
+    explicit Stdout(std::wstring_view file);
+    /** @overload */
     explicit Stdout(const CanonicalPath& file);
     /** Redirect child process's stdout to a pipe. */
     explicit Stdout(Pipe&);
@@ -51,6 +55,8 @@ struct Stderr : Stream {
     /** Redirect child process's stderr to a file. */
     explicit Stderr(std::string_view file);
     /** @overload */
+    explicit Stderr(std::wstring_view file);
+    /** @overload */
     explicit Stderr(const CanonicalPath& file);
     /** Redirect child process's stderr to a pipe. */
     explicit Stderr(Pipe&);
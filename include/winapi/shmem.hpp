@@ -8,13 +8,21 @@
 #include "handle.hpp"
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <string>
 #include <string_view>
 #include <type_traits>
 #include <utility>
 
 namespace winapi {
 
+/** @brief Deleter for memory-mapped views. */
+struct UnmapView {
+    void operator()(void*) const;
+};
+
 /** @brief Named shared memory region. */
 class SharedMemory {
 public:
@@ -24,11 +32,22 @@ public:
      * @param nb   Number of bytes.
      */
     static SharedMemory create(std::string_view name, std::size_t nb);
+    /**
+     * Creates a shared memory region.
+     * @param name UTF-16 string.
+     * @param nb   Number of bytes.
+     */
+    static SharedMemory create(std::wstring_view name, std::size_t nb);
     /**
      * Opens a shared memory region.
      * @param name UTF-8 string.
      */
     static SharedMemory open(std::string_view name);
+    /**
+     * Opens a shared memory region.
+     * @param name UTF-16 string.
+     */
+    static SharedMemory open(std::wstring_view name);
 
     /** Get pointer to the data. */
     void* get() const {
@@ -40,16 +59,88 @@ public:
     }
 
 private:
-    struct Unmap {
-        void operator()(void*) const;
-    };
-
     SharedMemory() = default;
 
+    static SharedMemory create_mapping(const std::wstring& name, std::size_t nb);
+    static SharedMemory open_mapping(const std::wstring& name);
+
     SharedMemory(Handle&& handle, void* addr) : m_handle{std::move(handle)}, m_addr{addr} {}
 
     Handle m_handle;
-    std::unique_ptr<void, Unmap> m_addr;
+    std::unique_ptr<void, UnmapView> m_addr;
+};
+
+/**
+ * @brief Read-only view of a file mapped into memory.
+ *
+ * Reading from the view doesn't copy anything, the pages are read from the
+ * file on access.
+ * The view stays valid after the file is closed.
+ * Use File::map_r() to create one.
+ */
+class MappedView {
+public:
+    /**
+     * Map a range of a file.
+     * @param file   File opened for reading.
+     * @param offset Offset of the range, doesn't need to be aligned.
+     * @param nb     Number of bytes, the range must be inside the file.
+     */
+    static MappedView map_r(const Handle& file, std::uint64_t offset, std::size_t nb);
+
+    /** Create an empty view. */
+    MappedView() = default;
+
+    MappedView(MappedView&& other) noexcept
+        : m_addr{std::move(other.m_addr)}
+        , m_data{std::exchange(other.m_data, nullptr)}
+        , m_size{std::exchange(other.m_size, 0)} {}
+
+    MappedView& operator=(MappedView&& other) noexcept {
+        m_addr = std::move(other.m_addr);
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+        return *this;
+    }
+
+    /** Get the mapped bytes. */
+    std::span<const std::byte> get() const {
+        return {m_data, m_size};
+    }
+
+    const std::byte* data() const {
+        return m_data;
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    /**
+     * Ask the system to read the whole view into memory ahead of time.
+     * This is just a hint, which makes subsequent sequential access faster.
+     */
+    void prefetch() const {
+        prefetch(0, size());
+    }
+    /**
+     * Ask the system to read a part of the view into memory ahead of time.
+     * @param offset Offset inside the view.
+     * @param nb     Number of bytes.
+     */
+    void prefetch(std::size_t offset, std::size_t nb) const;
+
+private:
+    MappedView(void* addr, std::size_t delta, std::size_t nb)
+        : m_addr{addr}, m_data{static_cast<const std::byte*>(addr) + delta}, m_size{nb} {}
+
+    std::unique_ptr<void, UnmapView> m_addr;
+    const std::byte* m_data = nullptr;
+    std::size_t m_size = 0;
 };
 
 /** @brief Easy way to represent a C++ object as a shared memory region. */
@@ -65,10 +156,19 @@ public:
      */
     template <typename... Args>
     static SharedObject create(std::string_view name, Args&&... args) {
-        SharedObject obj{SharedMemory::create(name, sizeof(AlignedType))};
-        new (obj.ptr()) T(std::forward<Args>(args)...);
-        obj.m_destruct = true;
-        return obj;
+        auto shmem = SharedMemory::create(name, sizeof(AlignedType));
+        return construct(std::move(shmem), std::forward<Args>(args)...);
+    }
+
+    /**
+     * Create the object & construct a shared memory region to store it.
+     * @param name UTF-16 string, name of the shared memory region.
+     * @param args Arguments to construct the object.
+     */
+    template <typename... Args>
+    static SharedObject create(std::wstring_view name, Args&&... args) {
+        auto shmem = SharedMemory::create(name, sizeof(AlignedType));
+        return construct(std::move(shmem), std::forward<Args>(args)...);
     }
 
     /**
@@ -80,6 +180,15 @@ public:
         return obj;
     }
 
+    /**
+     * Open a shared memory region that stores the object.
+     * @param name UTF-16 string, name of the shared memory region.
+     */
+    static SharedObject open(std::wstring_view name) {
+        SharedObject obj{SharedMemory::open(name)};
+        return obj;
+    }
+
     SharedObject(SharedObject&& other) noexcept = default;
     SharedObject& operator=(const SharedObject& other) noexcept = default;
     SharedObject(const SharedObject&) = delete;
@@ -110,6 +219,14 @@ public:
 private:
     explicit SharedObject(SharedMemory&& shmem) : m_shmem{std::move(shmem)} {}
 
+    template <typename... Args>
+    static SharedObject construct(SharedMemory&& shmem, Args&&... args) {
+        SharedObject obj{std::move(shmem)};
+        new (obj.ptr()) T(std::forward<Args>(args)...);
+        obj.m_destruct = true;
+        return obj;
+    }
+
     SharedMemory m_shmem;
     // Destruct only once, no matter the number of mappings.
     bool m_destruct = false;
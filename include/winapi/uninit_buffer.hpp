@@ -0,0 +1,102 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace winapi {
+
+/**
+ * @brief Growable byte array that doesn't initialize the bytes it grows by.
+ *
+ * Buffer is a `std::vector<unsigned char>`, which zero-fills the new bytes
+ * every time it grows, even if they're about to be overwritten by a read.
+ * Reading into this buffer instead, and copying only the bytes that have
+ * actually been read, avoids that.
+ */
+class UninitBuffer {
+public:
+    /** Create an empty buffer. */
+    UninitBuffer() = default;
+
+    /**
+     * Allocate a buffer.
+     * @param nb Number of bytes, left uninitialized.
+     */
+    explicit UninitBuffer(std::size_t nb) {
+        resize(nb);
+    }
+
+    UninitBuffer(UninitBuffer&& other) noexcept
+        : m_data{std::move(other.m_data)},
+          m_size{std::exchange(other.m_size, 0)},
+          m_capacity{std::exchange(other.m_capacity, 0)} {}
+
+    UninitBuffer& operator=(UninitBuffer&& other) noexcept {
+        m_data = std::move(other.m_data);
+        m_size = std::exchange(other.m_size, 0);
+        m_capacity = std::exchange(other.m_capacity, 0);
+        return *this;
+    }
+
+    unsigned char* data() const {
+        return m_data.get();
+    }
+
+    std::size_t size() const {
+        return m_size;
+    }
+
+    std::size_t capacity() const {
+        return m_capacity;
+    }
+
+    bool empty() const {
+        return m_size == 0;
+    }
+
+    std::span<unsigned char> get() const {
+        return {data(), size()};
+    }
+
+    /**
+     * Resize the buffer, keeping its contents.
+     * The bytes it grows by are left uninitialized.
+     */
+    void resize(std::size_t nb) {
+        if (nb > m_capacity)
+            reserve(std::max(nb, m_capacity + m_capacity / 2));
+        m_size = nb;
+    }
+
+    /** Make room for at least `nb` bytes, keeping the contents. */
+    void reserve(std::size_t nb) {
+        if (nb <= m_capacity)
+            return;
+        auto data = std::make_unique_for_overwrite<unsigned char[]>(nb);
+        if (m_size != 0)
+            std::memcpy(data.get(), m_data.get(), m_size);
+        m_data = std::move(data);
+        m_capacity = nb;
+    }
+
+    /** Empty the buffer, keeping the memory. */
+    void clear() {
+        m_size = 0;
+    }
+
+private:
+    std::unique_ptr<unsigned char[]> m_data;
+    std::size_t m_size = 0;
+    std::size_t m_capacity = 0;
+};
+
+} // namespace winapi
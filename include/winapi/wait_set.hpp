@@ -0,0 +1,117 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#pragma once
+
+#include "handle.hpp"
+
+#include <windows.h>
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace winapi {
+
+/**
+ * @brief Waits for any number of handles at once.
+ *
+ * WaitForMultipleObjects can only wait for up to MAXIMUM_WAIT_OBJECTS (64)
+ * handles.
+ * Larger sets are split into groups, which wait_any() waits for using helper
+ * threads.
+ * The helpers are started by the first wait, and kept until the set changes.
+ *
+ * A helper gives back whatever its wait acquired (auto-reset events,
+ * semaphores & mutexes), and the calling thread then acquires the object
+ * itself, so that a mutex is owned by the caller & nothing is lost.
+ * Giving back an event means setting it, so a manual-reset event that's
+ * reset at the same time might end up set again.
+ *
+ * The handles aren't owned by the set, and must outlive it.
+ * Don't wait for the same set on multiple threads at once.
+ */
+class WaitSet {
+public:
+    WaitSet();
+    ~WaitSet();
+
+    /** Copy the handles, but not the helper threads. */
+    WaitSet(const WaitSet& other);
+    WaitSet& operator=(const WaitSet& other);
+
+    WaitSet(WaitSet&& other) noexcept;
+    WaitSet& operator=(WaitSet&& other) noexcept;
+
+    /**
+     * Add a handle to the set.
+     * @return Index of the handle in the set.
+     */
+    std::size_t add(const Handle& handle) {
+        return add(handle.get());
+    }
+    /** @overload */
+    std::size_t add(HANDLE handle) {
+        stop_helpers();
+        m_handles.emplace_back(handle);
+        return m_handles.size() - 1;
+    }
+
+    /** Remove a handle; the indices of the handles after it shift down. */
+    void remove(std::size_t index);
+
+    void clear() {
+        stop_helpers();
+        m_handles.clear();
+    }
+
+    std::size_t size() const {
+        return m_handles.size();
+    }
+
+    bool empty() const {
+        return m_handles.empty();
+    }
+
+    /**
+     * Wait until any of the handles is signalled.
+     * @return Index of a signalled handle.
+     */
+    std::size_t wait_any() const;
+    /**
+     * Wait until any of the handles is signalled, with a timeout.
+     * @return Index of a signalled handle, or nothing on timeout.
+     */
+    std::optional<std::size_t> wait_any(std::chrono::milliseconds timeout) const;
+
+    /**
+     * Wait until all of the handles are signalled.
+     * When there're more than MAXIMUM_WAIT_OBJECTS handles, they're waited
+     * for group by group, so the handles must stay signalled (like processes
+     * & manual-reset events do).
+     */
+    void wait_all() const;
+    /**
+     * Wait until all of the handles are signalled, with a timeout.
+     * @return `true` if all of the handles are signalled, `false` on timeout.
+     */
+    bool wait_all(std::chrono::milliseconds timeout) const;
+
+private:
+    class Helpers;
+
+    std::optional<std::size_t> wait_any(DWORD timeout) const;
+    bool wait_all(DWORD timeout) const;
+
+    void stop_helpers();
+
+    std::vector<HANDLE> m_handles;
+    // Only for sets larger than MAXIMUM_WAIT_OBJECTS.
+    mutable std::unique_ptr<Helpers> m_helpers;
+};
+
+} // namespace winapi
@@ -0,0 +1,51 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include <winapi/aligned_buffer.hpp>
+#include <winapi/error.hpp>
+#include <winapi/utils.hpp>
+
+#include <windows.h>
+
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+namespace winapi {
+
+void AlignedBuffer::Free::operator()(unsigned char* ptr) const {
+    const auto ret = ::VirtualFree(ptr, 0, MEM_RELEASE);
+    assert(ret);
+    WINAPI_UNUSED_PARAMETER(ret);
+}
+
+std::size_t AlignedBuffer::round_up(std::size_t nb, std::size_t multiple) {
+    if (multiple == 0)
+        throw std::range_error{"Can't round up to a multiple of zero"};
+    const auto remainder = nb % multiple;
+    if (remainder == 0)
+        return nb;
+    if (nb > std::numeric_limits<std::size_t>::max() - (multiple - remainder))
+        throw std::range_error{"Aligned size is too large"};
+    return nb + (multiple - remainder);
+}
+
+AlignedBuffer::AlignedBuffer(std::size_t nb) {
+    if (nb == 0)
+        return;
+    nb = round_up(nb);
+
+    const auto ptr = ::VirtualAlloc(NULL, nb, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+
+    if (ptr == NULL) {
+        throw error::windows(GetLastError(), "VirtualAlloc");
+    }
+
+    m_data.reset(static_cast<unsigned char*>(ptr));
+    m_size = nb;
+}
+
+} // namespace winapi
@@ -0,0 +1,133 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+/**
+ * @file
+ * @brief Helpers shared by the asynchronous I/O & waiting code.
+ */
+
+#pragma once
+
+#include <winapi/error.hpp>
+#include <winapi/handle.hpp>
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace winapi::async {
+
+/** Check that an overlapped read or write fits into a single call. */
+inline DWORD check_io_size(std::size_t nb) {
+    if (nb > std::numeric_limits<DWORD>::max())
+        throw std::range_error{"Overlapped I/O size is too large"};
+    return static_cast<DWORD>(nb);
+}
+
+/** Whether a failed overlapped read has simply hit the end of the data. */
+inline bool is_eof_error(DWORD ec) {
+    return ec == ERROR_HANDLE_EOF || ec == ERROR_BROKEN_PIPE;
+}
+
+/**
+ * Create a manual-reset event, which is what GetOverlappedResult requires.
+ * It's initially non-signalled.
+ */
+inline Handle create_event() {
+    const auto event = ::CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (event == NULL)
+        throw error::windows(GetLastError(), "CreateEventW");
+    return Handle{event};
+}
+
+namespace detail {
+
+struct EventPool {
+    // Enough for a few threads with a few operations in flight each.
+    static constexpr std::size_t max_size = 64;
+
+    std::mutex mtx;
+    std::vector<Handle> events;
+};
+
+inline EventPool& event_pool() {
+    static EventPool pool;
+    return pool;
+}
+
+} // namespace detail
+
+/**
+ * Take a non-signalled manual-reset event from a process-wide pool.
+ * Every overlapped operation needs an event of its own, and creating one is
+ * a system call; use release_event() to put it back once the operation has
+ * completed.
+ */
+inline Handle acquire_event() {
+    {
+        auto& pool = detail::event_pool();
+        std::lock_guard<std::mutex> lck{pool.mtx};
+        if (!pool.events.empty()) {
+            auto event = std::move(pool.events.back());
+            pool.events.pop_back();
+            return event;
+        }
+    }
+    return create_event();
+}
+
+/**
+ * Put an event taken using acquire_event() back into the pool.
+ * Don't do this while an operation might still signal it.
+ */
+inline void release_event(Handle event) noexcept {
+    // A signalled event would make the next wait return right away.
+    if (!event.is_valid() || !::ResetEvent(event.get()))
+        return;
+    try {
+        auto& pool = detail::event_pool();
+        std::lock_guard<std::mutex> lck{pool.mtx};
+        if (pool.events.size() < detail::EventPool::max_size)
+            pool.events.emplace_back(std::move(event));
+    } catch (...) {
+        // The event is simply closed then.
+    }
+}
+
+/** @brief Event taken from the pool for the duration of a scope. */
+class PooledEvent {
+public:
+    PooledEvent() : m_event{acquire_event()} {}
+    ~PooledEvent() {
+        release_event(std::move(m_event));
+    }
+
+    PooledEvent(const PooledEvent&) = delete;
+    PooledEvent& operator=(const PooledEvent&) = delete;
+
+    HANDLE get() const {
+        return m_event.get();
+    }
+
+private:
+    Handle m_event;
+};
+
+/** Convert a timeout for use with the WaitFor* functions. */
+inline DWORD to_timeout(std::chrono::milliseconds timeout) {
+    // INFINITE is a special value, so stop one short of it.
+    static constexpr std::chrono::milliseconds::rep max_timeout = INFINITE - 1;
+    return static_cast<DWORD>(std::clamp<std::chrono::milliseconds::rep>(
+        timeout.count(), 0, max_timeout));
+}
+
+} // namespace winapi::async
@@ -0,0 +1,218 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "async.hpp"
+
+#include <winapi/async_io.hpp>
+#include <winapi/buffer.hpp>
+#include <winapi/error.hpp>
+#include <winapi/handle.hpp>
+#include <winapi/io_stats.hpp>
+
+#include <windows.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+namespace winapi {
+
+AsyncIo::State::State(HANDLE handle, std::uint64_t offset)
+    : handle{handle}, event{async::acquire_event()} {
+    std::memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    overlapped.hEvent = event.get();
+}
+
+AsyncIo::State::~State() {
+    async::release_event(std::move(event));
+}
+
+AsyncIo AsyncIo::read(HANDLE handle, std::size_t nb, std::uint64_t offset) {
+    const auto nb_dword = async::check_io_size(nb);
+
+    AsyncIo io{std::make_unique<State>(handle, offset)};
+    auto& state = *io.m_state;
+    state.reading = true;
+    state.buffer.resize(nb);
+#ifdef WINAPI_COMMON_IO_STATS
+    state.start = IoStats::Clock::now();
+#endif
+
+    if (!::ReadFile(handle, state.buffer.data(), nb_dword, NULL, &state.overlapped))
+        io.started("ReadFile");
+    return io;
+}
+
+AsyncIo AsyncIo::write(HANDLE handle, Buffer buffer, std::uint64_t offset) {
+    const auto nb_dword = async::check_io_size(buffer.size());
+
+    AsyncIo io{std::make_unique<State>(handle, offset)};
+    auto& state = *io.m_state;
+    state.buffer = std::move(buffer);
+#ifdef WINAPI_COMMON_IO_STATS
+    state.start = IoStats::Clock::now();
+#endif
+
+    if (!::WriteFile(handle, state.buffer.data(), nb_dword, NULL, &state.overlapped))
+        io.started("WriteFile");
+    return io;
+}
+
+AsyncIo& AsyncIo::operator=(AsyncIo&& other) noexcept {
+    if (this != &other) {
+        abandon();
+        m_state = std::move(other.m_state);
+    }
+    return *this;
+}
+
+AsyncIo::~AsyncIo() {
+    abandon();
+}
+
+void AsyncIo::abandon() noexcept {
+    if (!m_state || m_state->done)
+        return;
+    try {
+        cancel();
+    } catch (...) {
+    }
+    if (!m_state->done) {
+        // We couldn't make sure the operation's over, and the kernel might
+        // still write into the OVERLAPPED structure & the buffer: leaking
+        // them is the only safe option.
+        static_cast<void>(m_state.release());
+    }
+}
+
+void AsyncIo::started(const char* function) {
+    const auto ec = GetLastError();
+    if (ec == ERROR_IO_PENDING)
+        return;
+
+    // The operation has failed immediately, there's nothing to wait for.
+    m_state->done = true;
+    if (m_state->reading && async::is_eof_error(ec)) {
+        m_state->eof = true;
+        record();
+        m_state->buffer.clear();
+        return;
+    }
+    throw error::windows(ec, function);
+}
+
+void AsyncIo::complete(bool block) {
+    auto& state = *m_state;
+    if (state.done)
+        return;
+
+    DWORD nb = 0;
+    const auto ret = ::GetOverlappedResult(state.handle, &state.overlapped, &nb, block);
+    state.done = true;
+
+    if (!ret) {
+        const auto ec = GetLastError();
+        if (!state.reading || !async::is_eof_error(ec))
+            throw error::windows(ec, "GetOverlappedResult");
+        state.eof = true;
+        nb = 0;
+    }
+
+    state.nb = nb;
+    record();
+    if (state.reading)
+        state.buffer.resize(nb);
+}
+
+void AsyncIo::record() const {
+#ifdef WINAPI_COMMON_IO_STATS
+    // Only the raw handle is at hand here.
+    const auto& state = *m_state;
+    const auto latency = IoStats::Clock::now() - state.start;
+    if (state.reading)
+        IoStats::global().record_read(state.buffer.size(), state.nb, latency);
+    else
+        IoStats::global().record_write(state.nb, latency);
+#endif
+}
+
+bool AsyncIo::is_ready() const {
+    return m_state->done || HasOverlappedIoCompleted(&m_state->overlapped);
+}
+
+std::size_t AsyncIo::wait() {
+    complete(true);
+    return m_state->nb;
+}
+
+bool AsyncIo::wait_for(std::chrono::milliseconds timeout) {
+    if (m_state->done)
+        return true;
+
+    const auto ret = ::WaitForSingleObject(m_state->event.get(), async::to_timeout(timeout));
+
+    switch (ret) {
+        case WAIT_OBJECT_0:
+            complete(true);
+            return true;
+        case WAIT_TIMEOUT:
+            return false;
+        default:
+            throw error::windows(GetLastError(), "WaitForSingleObject");
+    }
+}
+
+void AsyncIo::cancel() {
+    auto& state = *m_state;
+    if (state.done)
+        return;
+
+    DWORD cancel_ec = ERROR_SUCCESS;
+    if (!::CancelIoEx(state.handle, &state.overlapped)) {
+        cancel_ec = GetLastError();
+        // ERROR_NOT_FOUND means the operation has already completed.
+        if (cancel_ec == ERROR_NOT_FOUND)
+            cancel_ec = ERROR_SUCCESS;
+    }
+
+    // The kernel might still be using the buffer until the operation
+    // completes, whether it's been cancelled or not.
+    if (!wait_until_done())
+        throw error::windows(GetLastError(), "GetOverlappedResult");
+    if (cancel_ec != ERROR_SUCCESS)
+        throw error::windows(cancel_ec, "CancelIoEx");
+}
+
+bool AsyncIo::wait_until_done() noexcept {
+    auto& state = *m_state;
+
+    DWORD nb = 0;
+    const auto ret = ::GetOverlappedResult(state.handle, &state.overlapped, &nb, TRUE);
+    // A failure either is the operation's own, or means we couldn't wait.
+    if (!ret && !HasOverlappedIoCompleted(&state.overlapped))
+        return false;
+
+    state.done = true;
+    state.nb = ret ? nb : 0;
+    if (state.reading)
+        // Shrinking doesn't reallocate.
+        state.buffer.resize(state.nb);
+    return true;
+}
+
+std::size_t AsyncIo::get_size() const {
+    return m_state->nb;
+}
+
+bool AsyncIo::is_eof() const {
+    return m_state->eof;
+}
+
+} // namespace winapi
@@ -0,0 +1,111 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include <winapi/buffer.hpp>
+#include <winapi/buffer_pool.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace winapi {
+namespace {
+
+std::uint64_t next_pool_id() {
+    static std::atomic<std::uint64_t> id{0};
+    return ++id;
+}
+
+struct ThreadCache {
+    // Pools are identified by unique IDs instead of pointers, so that a
+    // pool that's been destroyed can never be confused with a new one.
+    struct Entry {
+        std::uint64_t pool_id;
+        std::weak_ptr<const void> pool_alive;
+        std::vector<Buffer> free;
+    };
+
+    std::vector<Entry> entries;
+
+    Entry* find(std::uint64_t id) {
+        for (auto& entry : entries)
+            if (entry.pool_id == id)
+                return &entry;
+        return nullptr;
+    }
+
+    // Returns nullptr if there's no room for another pool.
+    Entry* bind(std::uint64_t id, const std::shared_ptr<const void>& alive) {
+        if (const auto entry = find(id))
+            return entry;
+        // Only the pools that have been destroyed make room for new ones.
+        std::erase_if(entries, [](const Entry& entry) { return entry.pool_alive.expired(); });
+        if (entries.size() >= BufferPool::thread_cache_pools)
+            return nullptr;
+        entries.push_back({id, alive, {}});
+        return &entries.back();
+    }
+};
+
+thread_local ThreadCache thread_cache;
+
+} // namespace
+
+BufferPool::BufferPool(std::size_t chunk_size, std::size_t max_free)
+    : m_id{next_pool_id()},
+      m_alive{std::make_shared<char>()},
+      m_chunk_size{chunk_size},
+      m_max_free{max_free} {
+    if (m_chunk_size == 0)
+        throw std::range_error{"Buffer pool chunk size must be positive"};
+}
+
+Buffer BufferPool::acquire() {
+    const auto cache = thread_cache.find(m_id);
+
+    if (cache && !cache->free.empty()) {
+        auto buffer = std::move(cache->free.back());
+        cache->free.pop_back();
+        return buffer;
+    }
+
+    {
+        std::lock_guard<std::mutex> lck{m_mtx};
+        if (!m_free.empty()) {
+            auto buffer = std::move(m_free.back());
+            m_free.pop_back();
+            return buffer;
+        }
+    }
+
+    Buffer buffer;
+    buffer.reserve(m_chunk_size);
+    return buffer;
+}
+
+void BufferPool::release(Buffer&& buffer) {
+    // Buffers that have been grown past the chunk size would waste memory.
+    if (buffer.capacity() != m_chunk_size)
+        return;
+    buffer.clear();
+
+    const auto cache = thread_cache.bind(m_id, m_alive);
+
+    if (cache && cache->free.size() < thread_cache_size) {
+        cache->free.emplace_back(std::move(buffer));
+        return;
+    }
+
+    std::lock_guard<std::mutex> lck{m_mtx};
+    if (m_free.size() < m_max_free)
+        m_free.emplace_back(std::move(buffer));
+}
+
+} // namespace winapi
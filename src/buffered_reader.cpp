@@ -0,0 +1,108 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include <winapi/buffered_reader.hpp>
+#include <winapi/handle.hpp>
+#include <winapi/uninit_buffer.hpp>
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WINAPI_HAVE_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace winapi {
+namespace {
+
+// SSE2 is part of the baseline on x64, so there's no need for runtime
+// dispatching here.
+const unsigned char* find_newline(const unsigned char* begin, const unsigned char* end) {
+    auto it = begin;
+
+#ifdef WINAPI_HAVE_SSE2
+    const auto newline = _mm_set1_epi8('\n');
+    for (; end - it >= 16; it += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, newline)));
+        if (mask != 0)
+            return it + std::countr_zero(mask);
+    }
+#endif
+
+    for (; it != end; ++it)
+        if (*it == '\n')
+            return it;
+    return end;
+}
+
+// A \r is only a part of the terminator if it's followed by a \n.
+std::string_view make_line(const unsigned char* begin, const unsigned char* end, bool terminated) {
+    if (terminated && begin != end && end[-1] == '\r')
+        --end;
+    return {reinterpret_cast<const char*>(begin), static_cast<std::size_t>(end - begin)};
+}
+
+} // namespace
+
+BufferedReader::BufferedReader(const Handle& handle, std::size_t chunk_size)
+    : m_handle{handle}, m_chunk_size{chunk_size} {
+    if (m_chunk_size == 0)
+        throw std::range_error{"Read chunk size must be positive"};
+}
+
+std::optional<std::string_view> BufferedReader::read_line() {
+    while (true) {
+        const auto data = m_buffer.data();
+        const auto end = data + m_buffer.size();
+        const auto newline = find_newline(data + m_scanned, end);
+
+        if (newline != end) {
+            const auto line = make_line(data + m_begin, newline, true);
+            m_begin = m_scanned = newline - data + 1;
+            return line;
+        }
+        m_scanned = m_buffer.size();
+
+        if (!m_eof && fill())
+            continue;
+
+        if (m_begin == m_buffer.size())
+            return {};
+        // The last line isn't terminated.
+        const auto data_end = m_buffer.data() + m_buffer.size();
+        const auto line = make_line(m_buffer.data() + m_begin, data_end, false);
+        m_begin = m_scanned = m_buffer.size();
+        return line;
+    }
+}
+
+bool BufferedReader::fill() {
+    if (m_begin != 0) {
+        // Only the unfinished line is moved, which is usually short.
+        const auto remaining = m_buffer.size() - m_begin;
+        std::memmove(m_buffer.data(), m_buffer.data() + m_begin, remaining);
+        m_buffer.resize(remaining);
+        m_scanned -= m_begin;
+        m_begin = 0;
+    }
+
+    const auto offset = m_buffer.size();
+    m_buffer.resize(offset + m_chunk_size);
+    std::size_t nb_read = 0;
+    const auto more = m_handle.read_chunk(m_buffer.data() + offset, m_chunk_size, nb_read);
+    m_buffer.resize(offset + nb_read);
+
+    if (!more)
+        m_eof = true;
+    return nb_read != 0;
+}
+
+} // namespace winapi
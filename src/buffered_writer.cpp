@@ -0,0 +1,70 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include <winapi/buffer.hpp>
+#include <winapi/buffered_writer.hpp>
+#include <winapi/handle.hpp>
+
+#include <cstddef>
+#include <format>
+#include <stdexcept>
+
+namespace winapi {
+
+BufferedWriter::BufferedWriter(const Handle& handle, std::size_t buffer_size)
+    : m_handle{handle}, m_buffer_size{buffer_size} {
+    if (m_buffer_size == 0)
+        throw std::range_error{"Write buffer size must be positive"};
+}
+
+BufferedWriter::~BufferedWriter() {
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+void BufferedWriter::write(const void* data, std::size_t nb) {
+    if (m_buffer.size() + nb > m_buffer_size)
+        flush();
+
+    if (nb >= m_buffer_size) {
+        // It wouldn't fit anyway, don't bother copying it.
+        m_handle.write(data, nb);
+        return;
+    }
+
+    if (m_buffer.capacity() < m_buffer_size)
+        m_buffer.reserve(m_buffer_size);
+
+    m_buffer.add(data, nb);
+
+    if (m_buffer.size() == m_buffer_size)
+        flush();
+}
+
+void BufferedWriter::flush() {
+    std::size_t nb_written = 0;
+    try {
+        while (nb_written < m_buffer.size()) {
+            const auto nb = m_handle.write_some(
+                m_buffer.data() + nb_written, m_buffer.size() - nb_written
+            );
+            if (nb == 0)
+                throw std::runtime_error{std::format(
+                    "Could only write {} bytes instead of {}", nb_written, m_buffer.size()
+                )};
+            nb_written += nb;
+        }
+    } catch (...) {
+        // Don't write the same data twice, but keep the rest for the next
+        // flush.
+        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + nb_written);
+        throw;
+    }
+    m_buffer.clear();
+}
+
+} // namespace winapi
@@ -3,9 +3,10 @@
 // For details, see https://github.com/egor-tensin/winapi-common.
 // Distributed under the MIT License.
 
+#include "unicode.hpp"
+
 #include <winapi/cmd_line.hpp>
 #include <winapi/error.hpp>
-#include <winapi/utf8.hpp>
 #include <winapi/utils.hpp>
 
 #include <boost/algorithm/string.hpp>
@@ -18,7 +19,6 @@
 #include <cstddef>
 #include <format>
 #include <memory>
-#include <sstream>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -28,11 +28,19 @@
 namespace winapi {
 namespace {
 
-std::vector<std::string> narrow_all(int argc, wchar_t** argv) {
+std::vector<std::string> narrow_all(const std::vector<std::wstring>& xs) {
     std::vector<std::string> utf;
-    utf.reserve(argc);
-    for (int i = 0; i < argc; ++i)
-        utf.emplace_back(narrow(argv[i]));
+    utf.reserve(xs.size());
+    for (const auto& x : xs)
+        utf.emplace_back(unicode::narrow(x));
+    return utf;
+}
+
+std::vector<std::wstring> widen_all(const std::vector<std::string>& xs) {
+    std::vector<std::wstring> utf;
+    utf.reserve(xs.size());
+    for (const auto& x : xs)
+        utf.emplace_back(unicode::widen(x));
     return utf;
 }
 
@@ -52,10 +60,11 @@ CommandLine do_parse(std::wstring src) {
         throw std::runtime_error{"Command line must contain at least one token"};
     }
 
-    return CommandLine{narrow_all(argc, argv.get())};
+    return CommandLine{std::vector<std::wstring>{argv.get(), argv.get() + argc}};
 }
 
-std::string split_argv0(std::vector<std::string>& argv) {
+template <typename StringT>
+StringT split_argv0(std::vector<StringT>& argv) {
     if (argv.empty()) {
         throw std::range_error{"argv must contain at least one element"};
     }
@@ -64,8 +73,46 @@ std::string split_argv0(std::vector<std::string>& argv) {
     return argv0;
 }
 
-std::vector<std::string> escape_all(const std::vector<std::string>& xs) {
-    std::vector<std::string> escaped;
+template <typename CharT>
+std::basic_string<CharT> escape_arg(std::basic_string_view<CharT> arg) {
+    static constexpr CharT quote{'"'};
+    static constexpr CharT backslash{'\\'};
+
+    std::basic_string<CharT> safe;
+    safe.reserve(arg.size() + 2);
+    safe += quote;
+
+    for (auto it = arg.cbegin(); it != arg.cend(); ++it) {
+        std::size_t numof_backslashes = 0;
+
+        for (; it != arg.cend() && *it == backslash; ++it)
+            ++numof_backslashes;
+
+        if (it == arg.cend()) {
+            safe.append(2 * numof_backslashes, backslash);
+            break;
+        }
+
+        switch (*it) {
+            case quote:
+                safe.append(2 * numof_backslashes + 1, backslash);
+                break;
+
+            default:
+                safe.append(numof_backslashes, backslash);
+                break;
+        }
+
+        safe += *it;
+    }
+
+    safe += quote;
+    return safe;
+}
+
+template <typename StringT>
+std::vector<StringT> escape_all(const std::vector<StringT>& xs) {
+    std::vector<StringT> escaped;
     escaped.reserve(xs.size());
     for (const auto& x : xs)
         escaped.emplace_back(CommandLine::escape(x));
@@ -79,49 +126,49 @@ CommandLine CommandLine::query() {
 }
 
 CommandLine CommandLine::parse(std::string_view src) {
-    return do_parse(widen(src));
+    return do_parse(unicode::widen(src));
+}
+
+CommandLine CommandLine::parse(std::wstring_view src) {
+    return do_parse(std::wstring{src});
 }
 
 CommandLine CommandLine::from_main(int argc, wchar_t* argv[]) {
     if (argc < 1)
         throw std::range_error{"argc must be a positive number"};
-    return CommandLine{narrow_all(argc, argv)};
+    return CommandLine{std::vector<std::wstring>{argv, argv + argc}};
+}
+
+CommandLine::CommandLine(const std::string& argv0, const std::vector<std::string>& args)
+    : m_argv0{argv0}, m_args{args}, m_wargv0{unicode::widen(argv0)}, m_wargs{widen_all(args)} {}
+
+CommandLine::CommandLine(std::string&& argv0, std::vector<std::string>&& args)
+    : m_argv0{std::move(argv0)}, m_args{std::move(args)} {
+    m_wargv0 = unicode::widen(m_argv0);
+    m_wargs = widen_all(m_args);
 }
 
 CommandLine::CommandLine(std::vector<std::string> argv) : m_args{std::move(argv)} {
     m_argv0 = split_argv0(m_args);
+    m_wargv0 = unicode::widen(m_argv0);
+    m_wargs = widen_all(m_args);
 }
 
-std::string CommandLine::escape(std::string_view arg) {
-    std::ostringstream safe;
-    safe << '"';
-
-    for (auto it = arg.cbegin(); it != arg.cend(); ++it) {
-        std::size_t numof_backslashes = 0;
-
-        for (; it != arg.cend() && *it == '\\'; ++it)
-            ++numof_backslashes;
-
-        if (it == arg.cend()) {
-            safe << std::string(2 * numof_backslashes, '\\');
-            break;
-        }
+CommandLine::CommandLine(const std::wstring& argv0, const std::vector<std::wstring>& args)
+    : m_argv0{unicode::narrow(argv0)}, m_args{narrow_all(args)}, m_wargv0{argv0}, m_wargs{args} {}
 
-        switch (*it) {
-            case L'"':
-                safe << std::string(2 * numof_backslashes + 1, '\\');
-                break;
-
-            default:
-                safe << std::string(numof_backslashes, '\\');
-                break;
-        }
+CommandLine::CommandLine(std::vector<std::wstring> argv) : m_wargs{std::move(argv)} {
+    m_wargv0 = split_argv0(m_wargs);
+    m_argv0 = unicode::narrow(m_wargv0);
+    m_args = narrow_all(m_wargs);
+}
 
-        safe << *it;
-    }
+std::string CommandLine::escape(std::string_view arg) {
+    return escape_arg(arg);
+}
 
-    safe << '"';
-    return safe.str();
+std::wstring CommandLine::escape(std::wstring_view arg) {
+    return escape_arg(arg);
 }
 
 std::string CommandLine::escape_cmd(std::string_view arg) {
@@ -144,6 +191,16 @@ std::string CommandLine::args_to_string() const {
     return boost::algorithm::join(escape_args(), std::string{token_sep()});
 }
 
+std::wstring CommandLine::to_wstring() const {
+    auto argv = escape_all(get_wargs());
+    argv.emplace(argv.begin(), escape(get_wargv0()));
+    return boost::algorithm::join(argv, std::wstring{token_sep()});
+}
+
+std::wstring CommandLine::args_to_wstring() const {
+    return boost::algorithm::join(escape_all(get_wargs()), std::wstring{token_sep()});
+}
+
 std::vector<std::string> CommandLine::get_argv() const {
     auto argv = get_args();
     argv.emplace(argv.begin(), get_argv0());
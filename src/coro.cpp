@@ -0,0 +1,71 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include <winapi/coro.hpp>
+#include <winapi/error.hpp>
+#include <winapi/io_completion_port.hpp>
+#include <winapi/process.hpp>
+
+#include <windows.h>
+
+#include <coroutine>
+
+namespace winapi::coro {
+
+bool WaitAwaiter::await_ready() const {
+    return ::WaitForSingleObject(m_handle, 0) == WAIT_OBJECT_0;
+}
+
+bool WaitAwaiter::await_suspend(std::coroutine_handle<> coroutine) {
+    m_coroutine = coroutine;
+
+    const auto ret = ::RegisterWaitForSingleObject(
+        &m_wait,
+        m_handle,
+        &on_signalled,
+        this,
+        INFINITE,
+        WT_EXECUTEONLYONCE | WT_EXECUTELONGFUNCTION
+    );
+
+    if (!ret) {
+        throw error::windows(GetLastError(), "RegisterWaitForSingleObject");
+    }
+
+    // If the callback has already been called, resume right away.
+    // Don't touch this object afterwards: the coroutine might've been resumed
+    // & destroyed it already.
+    return !m_registered.exchange(true);
+}
+
+void WaitAwaiter::await_resume() {
+    if (m_wait == NULL)
+        return;
+    const auto wait = m_wait;
+    m_wait = NULL;
+    // This is usually called from the callback itself, hence no waiting for
+    // the callback to complete.
+    ::UnregisterWaitEx(wait, NULL);
+}
+
+void CALLBACK WaitAwaiter::on_signalled(PVOID context, BOOLEAN) {
+    const auto self = static_cast<WaitAwaiter*>(context);
+    if (self->m_registered.exchange(true))
+        self->m_coroutine.resume();
+}
+
+ProcessExit::ProcessExit(const Process& process)
+    : WaitAwaiter{process.get_handle().get()}, m_process{process} {}
+
+int ProcessExit::await_resume() {
+    WaitAwaiter::await_resume();
+    return m_process.get_exit_code();
+}
+
+void Schedule::await_suspend(std::coroutine_handle<> coroutine) {
+    m_port.post([coroutine]() { coroutine.resume(); });
+}
+
+} // namespace winapi::coro
@@ -0,0 +1,351 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "parallel.hpp"
+#include "unicode.hpp"
+
+#include <winapi/directory.hpp>
+#include <winapi/error.hpp>
+#include <winapi/file.hpp>
+#include <winapi/path.hpp>
+
+#include <windows.h>
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace winapi {
+namespace {
+
+// Must fit at least one entry with the longest possible name.
+constexpr std::size_t min_buffer_size = 4 * 1024;
+
+constexpr auto no_more_entries = std::numeric_limits<std::size_t>::max();
+
+File open_directory(const std::wstring& path) {
+    auto options = File::OpenOptions::list_directory();
+    options.inheritable(false);
+    return File::open(std::wstring_view{path}, options);
+}
+
+DirEntry make_entry(const FILE_ID_BOTH_DIR_INFO& info, std::wstring_view name, ULONGLONG volume) {
+    FILE_ID_INFO id;
+    std::memset(&id, 0, sizeof(id));
+    id.VolumeSerialNumber = volume;
+    static_assert(sizeof(info.FileId) <= sizeof(id.FileId.Identifier));
+    std::memcpy(id.FileId.Identifier, &info.FileId, sizeof(info.FileId));
+
+    return DirEntry{
+        std::wstring{name},
+        info.FileAttributes,
+        static_cast<std::uint64_t>(info.EndOfFile.QuadPart),
+        info.CreationTime.QuadPart,
+        info.LastAccessTime.QuadPart,
+        info.LastWriteTime.QuadPart,
+        File::ID{id},
+    };
+}
+
+// File systems that don't support hard links don't need deduplication, and
+// their file IDs aren't necessarily unique: FAT reports 0 for every file.
+bool supports_hard_links(const File& dir) {
+    DWORD flags = 0;
+    if (!::GetVolumeInformationByHandleW(dir.get(), NULL, 0, NULL, NULL, &flags, NULL, 0))
+        // Better report a file twice than not report it at all.
+        return false;
+    return (flags & FILE_SUPPORTS_HARD_LINKS) != 0;
+}
+
+// 0 & -1 are used when there's no ID, or it doesn't fit into 64 bits (on
+// ReFS).
+bool has_unique_id(const DirEntry& entry) {
+    std::uint64_t id = 0;
+    std::memcpy(&id, entry.id.impl.FileId.Identifier, sizeof(id));
+    return id != 0 && id != std::numeric_limits<std::uint64_t>::max();
+}
+
+std::wstring join(const std::wstring& dir, const std::wstring& name) {
+    std::wstring path;
+    path.reserve(dir.size() + 1 + name.size());
+    path += dir;
+    if (!path.empty() && path.back() != L'\\' && path.back() != L'/')
+        path += L'\\';
+    path += name;
+    return path;
+}
+
+// File IDs of the files reported so far, split into shards to reduce lock
+// contention between the worker threads.
+class SeenFiles {
+public:
+    // Returns true if the file hasn't been seen before.
+    bool insert(const File::ID& id) {
+        auto& shard = m_shards[std::hash<File::ID>{}(id) % numof_shards];
+        std::lock_guard<std::mutex> lck{shard.mtx};
+        return shard.ids.insert(id).second;
+    }
+
+private:
+    static constexpr std::size_t numof_shards = 64;
+
+    struct Shard {
+        std::mutex mtx;
+        std::unordered_set<File::ID> ids;
+    };
+
+    std::array<Shard, numof_shards> m_shards;
+};
+
+class Walk {
+public:
+    Walk(
+        std::wstring root,
+        const DirectoryWalker::Callback& callback,
+        const DirectoryWalker::ErrorCallback& on_error
+    )
+        : m_callback{callback}, m_on_error{on_error}, m_root{open_directory(root)} {
+        // Reparse points aren't followed, so every directory is on the same
+        // volume as the root.
+        m_volume = m_root->query_id().impl.VolumeSerialNumber;
+        m_dedup = supports_hard_links(*m_root);
+        m_queue.emplace_back(std::move(root));
+    }
+
+    void run() {
+        while (auto dir = pop()) {
+            enumerate(*dir);
+            finish();
+        }
+    }
+
+    // Makes the workers quit early.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lck{m_mtx};
+            m_stopped = true;
+        }
+        m_cv.notify_all();
+    }
+
+private:
+    std::optional<std::wstring> pop() {
+        std::unique_lock<std::mutex> lck{m_mtx};
+        m_cv.wait(lck, [this]() { return m_stopped || !m_queue.empty() || m_busy == 0; });
+        // Either stopped or every directory has been enumerated.
+        if (m_stopped || m_queue.empty())
+            return std::nullopt;
+        auto dir = std::move(m_queue.front());
+        m_queue.pop_front();
+        ++m_busy;
+        return dir;
+    }
+
+    void push(std::vector<std::wstring>& dirs) {
+        if (dirs.empty())
+            return;
+        {
+            std::lock_guard<std::mutex> lck{m_mtx};
+            for (auto& dir : dirs)
+                m_queue.emplace_back(std::move(dir));
+        }
+        m_cv.notify_all();
+    }
+
+    void finish() {
+        bool done = false;
+        {
+            std::lock_guard<std::mutex> lck{m_mtx};
+            --m_busy;
+            done = m_busy == 0 && m_queue.empty();
+        }
+        if (done)
+            m_cv.notify_all();
+    }
+
+    File open(const std::wstring& dir) {
+        // The root has been opened already, & only a single thread gets to
+        // enumerate it.
+        if (m_root) {
+            auto root = std::move(*m_root);
+            m_root.reset();
+            return root;
+        }
+        return open_directory(dir);
+    }
+
+    void enumerate(const std::wstring& dir) {
+        std::vector<std::wstring> subdirs;
+        // Only the errors of the enumeration itself are passed to on_error.
+        bool in_callback = false;
+
+        try {
+            DirectoryIterator it{open(dir), m_volume};
+            while (const auto entry = it.next()) {
+                if (entry->is_directory()) {
+                    // Directories can't be hard-linked.
+                    if (!entry->is_reparse_point())
+                        subdirs.emplace_back(join(dir, entry->name));
+                } else if (m_dedup && has_unique_id(*entry) && !m_seen.insert(entry->id)) {
+                    continue;
+                }
+                in_callback = true;
+                m_callback(dir, *entry);
+                in_callback = false;
+            }
+        } catch (const std::system_error& e) {
+            if (in_callback || !m_on_error)
+                throw;
+            m_on_error(dir, e);
+        }
+
+        push(subdirs);
+    }
+
+    const DirectoryWalker::Callback& m_callback;
+    const DirectoryWalker::ErrorCallback& m_on_error;
+
+    std::optional<File> m_root;
+    ULONGLONG m_volume = 0;
+    bool m_dedup = false;
+
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    std::deque<std::wstring> m_queue;
+    // Number of directories being enumerated.
+    std::size_t m_busy = 0;
+    bool m_stopped = false;
+
+    SeenFiles m_seen;
+};
+
+} // namespace
+
+std::string DirEntry::get_name() const {
+    return unicode::narrow(name);
+}
+
+DirectoryIterator DirectoryIterator::open(std::string_view path, std::size_t buffer_size) {
+    return DirectoryIterator{File::open(path, File::OpenOptions::list_directory()), buffer_size};
+}
+
+DirectoryIterator DirectoryIterator::open(std::wstring_view path, std::size_t buffer_size) {
+    return DirectoryIterator{File::open(path, File::OpenOptions::list_directory()), buffer_size};
+}
+
+DirectoryIterator DirectoryIterator::open(const CanonicalPath& path, std::size_t buffer_size) {
+    return DirectoryIterator{File::open(path, File::OpenOptions::list_directory()), buffer_size};
+}
+
+DirectoryIterator::DirectoryIterator(File&& dir, std::size_t buffer_size)
+    : DirectoryIterator{std::move(dir), 0, buffer_size} {
+    m_volume = m_dir.query_id().impl.VolumeSerialNumber;
+}
+
+DirectoryIterator::DirectoryIterator(File&& dir, ULONGLONG volume, std::size_t buffer_size)
+    : m_dir{std::move(dir)}, m_volume{volume}, m_offset{no_more_entries} {
+    if (buffer_size < min_buffer_size)
+        throw std::range_error{"Directory buffer is too small"};
+    if (buffer_size > std::numeric_limits<DWORD>::max())
+        throw std::range_error{"Directory buffer is too large"};
+
+    m_buffer.resize(buffer_size);
+}
+
+std::optional<DirEntry> DirectoryIterator::next() {
+    while (true) {
+        if (m_offset == no_more_entries && !fill())
+            return std::nullopt;
+
+        const auto& info =
+            *reinterpret_cast<const FILE_ID_BOTH_DIR_INFO*>(m_buffer.data() + m_offset);
+        if (info.NextEntryOffset == 0)
+            m_offset = no_more_entries;
+        else
+            m_offset += info.NextEntryOffset;
+
+        const std::wstring_view name{info.FileName, info.FileNameLength / sizeof(WCHAR)};
+        if (name == L"." || name == L"..")
+            continue;
+        return make_entry(info, name, m_volume);
+    }
+}
+
+bool DirectoryIterator::fill() {
+    if (m_finished)
+        return false;
+
+    // The first call restarts the enumeration, even if the handle has
+    // already been used to enumerate the directory.
+    const auto cls = m_started ? FileIdBothDirectoryInfo : FileIdBothDirectoryRestartInfo;
+    m_started = true;
+
+    const auto ret = ::GetFileInformationByHandleEx(
+        m_dir.get(), cls, m_buffer.data(), static_cast<DWORD>(m_buffer.size())
+    );
+
+    if (!ret) {
+        const auto ec = GetLastError();
+        if (ec == ERROR_NO_MORE_FILES) {
+            m_finished = true;
+            return false;
+        }
+        throw error::windows(ec, "GetFileInformationByHandleEx");
+    }
+
+    m_offset = 0;
+    return true;
+}
+
+std::size_t DirectoryWalker::default_thread_count() {
+    return parallel::default_thread_count();
+}
+
+DirectoryWalker::DirectoryWalker(std::size_t thread_count) : m_thread_count{thread_count} {
+    if (m_thread_count == 0)
+        throw std::range_error{"Directory walker needs at least one thread"};
+}
+
+void DirectoryWalker::walk(
+    std::string_view root, const Callback& callback, const ErrorCallback& on_error
+) const {
+    walk_impl(unicode::widen(root), callback, on_error);
+}
+
+void DirectoryWalker::walk(
+    std::wstring_view root, const Callback& callback, const ErrorCallback& on_error
+) const {
+    walk_impl(std::wstring{root}, callback, on_error);
+}
+
+void DirectoryWalker::walk(
+    const CanonicalPath& root, const Callback& callback, const ErrorCallback& on_error
+) const {
+    walk_impl(LR"(\\?\)" + root.get_wide(), callback, on_error);
+}
+
+void DirectoryWalker::walk_impl(
+    std::wstring root, const Callback& callback, const ErrorCallback& on_error
+) const {
+    Walk walk{std::move(root), callback, on_error};
+    parallel::Workers workers{[&walk]() { walk.stop(); }};
+    workers.run(m_thread_count, [&walk]() { walk.run(); });
+}
+
+} // namespace winapi
@@ -3,8 +3,9 @@
 // For details, see https://github.com/egor-tensin/winapi-common.
 // Distributed under the MIT License.
 
+#include "unicode.hpp"
+
 #include <winapi/error.hpp>
-#include <winapi/utf8.hpp>
 
 #include <windows.h>
 
@@ -49,7 +50,7 @@ std::string format_message(int32_t code) {
 
     std::wstring msg{buf, len};
     ::LocalFree(buf);
-    return narrow(trim_trailing_newline(msg));
+    return unicode::narrow(trim_trailing_newline(msg));
 }
 
 } // namespace
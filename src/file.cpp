@@ -3,75 +3,65 @@
 // For details, see https://github.com/egor-tensin/winapi-common.
 // Distributed under the MIT License.
 
+#include "async.hpp"
+#include "parallel.hpp"
+#include "unicode.hpp"
+
+#include <winapi/aligned_buffer.hpp>
+#include <winapi/buffer.hpp>
 #include <winapi/error.hpp>
 #include <winapi/file.hpp>
 #include <winapi/handle.hpp>
+#include <winapi/io_stats.hpp>
 #include <winapi/path.hpp>
-#include <winapi/utf8.hpp>
+#include <winapi/shmem.hpp>
+
+#include <windows.h>
+#include <winioctl.h>
 
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <limits>
+#include <memory>
+#include <span>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 namespace winapi {
 namespace {
 
 std::wstring to_system_path(std::string_view path) {
-    return widen(path);
+    return unicode::widen(path);
 }
 
-std::wstring to_system_path(const CanonicalPath& path) {
-    return widen(R"(\\?\)" + path.get());
+std::wstring to_system_path(std::wstring_view path) {
+    return std::wstring{path};
 }
 
-struct CreateFileParams {
-    static CreateFileParams read() {
-        CreateFileParams params;
-        params.dwDesiredAccess = GENERIC_READ;
-        params.dwShareMode = FILE_SHARE_READ;
-        params.dwCreationDisposition = OPEN_EXISTING;
-        return params;
-    }
-
-    static CreateFileParams read_attributes() {
-        auto params = read();
-        params.dwDesiredAccess = FILE_READ_ATTRIBUTES;
-        params.dwShareMode = FILE_SHARE_READ | FILE_SHARE_WRITE;
-        return params;
-    }
-
-    static CreateFileParams write() {
-        CreateFileParams params;
-        params.dwDesiredAccess = GENERIC_WRITE;
-        params.dwShareMode = FILE_SHARE_READ;
-        params.dwCreationDisposition = OPEN_ALWAYS;
-        return params;
-    }
-
-    DWORD dwDesiredAccess = 0;
-    DWORD dwShareMode = 0;
-    DWORD dwCreationDisposition = 0;
-
-private:
-    CreateFileParams() = default;
-};
+std::wstring to_system_path(const CanonicalPath& path) {
+    return LR"(\\?\)" + path.get_wide();
+}
 
-File open_file(std::wstring_view path, const CreateFileParams& params) {
+File open_file(const std::wstring& path, const File::OpenOptions& options) {
     SECURITY_ATTRIBUTES attributes;
     std::memset(&attributes, 0, sizeof(attributes));
     attributes.nLength = sizeof(attributes);
-    attributes.bInheritHandle = TRUE;
+    attributes.bInheritHandle = options.is_inheritable() ? TRUE : FALSE;
 
     const auto handle = ::CreateFileW(
-        path.data(),
-        params.dwDesiredAccess,
-        params.dwShareMode,
+        path.c_str(),
+        options.get_access(),
+        options.get_share_mode(),
         &attributes,
-        params.dwCreationDisposition,
-        FILE_ATTRIBUTE_NORMAL,
+        options.get_creation_disposition(),
+        options.get_flags_and_attributes(),
         NULL
     );
 
@@ -82,58 +72,903 @@ File open_file(std::wstring_view path, const CreateFileParams& params) {
     return File{Handle{handle}};
 }
 
-void remove_file(std::wstring_view path) {
-    const auto ret = ::DeleteFileW(path.data());
+void remove_file(const std::wstring& path) {
+    const auto ret = ::DeleteFileW(path.c_str());
 
     if (!ret) {
         throw error::windows(GetLastError(), "DeleteFileW");
     }
 }
 
+std::uint64_t to_uint64(DWORD high, DWORD low) {
+    return (static_cast<std::uint64_t>(high) << 32) | low;
+}
+
+std::int64_t to_int64(const FILETIME& time) {
+    return static_cast<std::int64_t>(to_uint64(time.dwHighDateTime, time.dwLowDateTime));
+}
+
+// Files that are open without FILE_SHARE_READ, like pagefile.sys, can't be
+// queried using GetFileAttributesExW; their directory entries still can.
+DWORD find_file_attributes(const std::wstring& path, WIN32_FILE_ATTRIBUTE_DATA& data) {
+    WIN32_FIND_DATAW find_data;
+    const auto handle = ::FindFirstFileW(path.c_str(), &find_data);
+
+    if (handle == INVALID_HANDLE_VALUE)
+        return GetLastError();
+
+    ::FindClose(handle);
+    data.dwFileAttributes = find_data.dwFileAttributes;
+    data.nFileSizeHigh = find_data.nFileSizeHigh;
+    data.nFileSizeLow = find_data.nFileSizeLow;
+    data.ftLastWriteTime = find_data.ftLastWriteTime;
+    return ERROR_SUCCESS;
+}
+
+void stat_file(const std::wstring& path, File::Stats& stats, std::size_t i) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    DWORD ec = ERROR_SUCCESS;
+
+    if (!::GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &data)) {
+        ec = GetLastError();
+        if (ec == ERROR_SHARING_VIOLATION)
+            ec = find_file_attributes(path, data);
+    }
+
+    stats.errors[i] = ec;
+    if (ec != ERROR_SUCCESS)
+        return;
+    stats.attributes[i] = data.dwFileAttributes;
+    stats.sizes[i] = to_uint64(data.nFileSizeHigh, data.nFileSizeLow);
+    stats.last_write_times[i] = to_int64(data.ftLastWriteTime);
+}
+
+template <typename Path>
+File::Stats stat_many_impl(std::span<const Path> paths, std::size_t thread_count) {
+    // Threads grab paths in blocks, so that they don't contend for the
+    // counter or write to the same cache lines.
+    static constexpr std::size_t block_size = 256;
+
+    const auto nb = paths.size();
+
+    File::Stats stats;
+    stats.errors.resize(nb);
+    stats.attributes.resize(nb);
+    stats.sizes.resize(nb);
+    stats.last_write_times.resize(nb);
+
+    parallel::for_each(nb, block_size, thread_count, [&](std::uint64_t i) {
+        const auto j = static_cast<std::size_t>(i);
+        if constexpr (std::is_same_v<Path, std::wstring>)
+            stat_file(paths[j], stats, j);
+        else
+            stat_file(to_system_path(paths[j]), stats, j);
+    });
+    return stats;
+}
+
+LARGE_INTEGER to_large_integer(std::uint64_t nb) {
+    if (nb > static_cast<std::uint64_t>(std::numeric_limits<LONGLONG>::max()))
+        throw std::range_error{"File size or offset is too large"};
+    LARGE_INTEGER result;
+    result.QuadPart = static_cast<LONGLONG>(nb);
+    return result;
+}
+
+std::uint64_t get_file_size(HANDLE handle) {
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(handle, &size))
+        throw error::windows(GetLastError(), "GetFileSizeEx");
+
+    if (size.QuadPart < 0)
+        throw std::runtime_error{"invalid file size"};
+    return static_cast<std::uint64_t>(size.QuadPart);
+}
+
+bool enable_privilege(const wchar_t* name) {
+    HANDLE token_impl = NULL;
+
+    if (!::OpenProcessToken(::GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES, &token_impl))
+        return false;
+
+    const Handle token{token_impl};
+
+    TOKEN_PRIVILEGES privileges;
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+    if (!::LookupPrivilegeValueW(NULL, name, &privileges.Privileges[0].Luid))
+        return false;
+    if (!::AdjustTokenPrivileges(token.get(), FALSE, &privileges, 0, NULL, NULL))
+        return false;
+    // The call succeeds even if the token doesn't hold the privilege.
+    return GetLastError() != ERROR_NOT_ALL_ASSIGNED;
+}
+
+bool enable_manage_volume_privilege() {
+    // Needs to be done once per process.
+    static const bool enabled = enable_privilege(L"SeManageVolumePrivilege");
+    return enabled;
+}
+
+OVERLAPPED make_overlapped(std::uint64_t offset) {
+    OVERLAPPED overlapped;
+    std::memset(&overlapped, 0, sizeof(overlapped));
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    return overlapped;
+}
+
+// ReadFile & WriteFile can't transfer more than 4 GiB at once.
+DWORD clamp_io_size(std::size_t nb) {
+    return static_cast<DWORD>(std::min<std::size_t>(nb, std::numeric_limits<DWORD>::max()));
+}
+
+// Positional reads & writes work with both synchronous & overlapped handles.
+// Windows runs the ones using a synchronous handle one at a time though,
+// while the ones using an overlapped handle can run in parallel.
+DWORD read_file_at(HANDLE handle, std::uint64_t offset, void* dest, DWORD nb) {
+    const async::PooledEvent event;
+    auto overlapped = make_overlapped(offset);
+    overlapped.hEvent = event.get();
+
+    if (!::ReadFile(handle, dest, nb, NULL, &overlapped)) {
+        const auto ec = GetLastError();
+        if (ec == ERROR_HANDLE_EOF)
+            return 0;
+        if (ec != ERROR_IO_PENDING)
+            throw error::windows(ec, "ReadFile");
+    }
+
+    DWORD nb_read = 0;
+    if (!::GetOverlappedResult(handle, &overlapped, &nb_read, TRUE)) {
+        const auto ec = GetLastError();
+        if (ec == ERROR_HANDLE_EOF)
+            return 0;
+        throw error::windows(ec, "GetOverlappedResult");
+    }
+    return nb_read;
+}
+
+DWORD write_file_at(HANDLE handle, std::uint64_t offset, const void* src, DWORD nb) {
+    const async::PooledEvent event;
+    auto overlapped = make_overlapped(offset);
+    overlapped.hEvent = event.get();
+
+    if (!::WriteFile(handle, src, nb, NULL, &overlapped)) {
+        const auto ec = GetLastError();
+        if (ec != ERROR_IO_PENDING)
+            throw error::windows(ec, "WriteFile");
+    }
+
+    DWORD nb_written = 0;
+    if (!::GetOverlappedResult(handle, &overlapped, &nb_written, TRUE))
+        throw error::windows(GetLastError(), "GetOverlappedResult");
+    return nb_written;
+}
+
+std::size_t read_at_impl(HANDLE handle, std::uint64_t offset, std::span<unsigned char> dest) {
+    std::size_t total = 0;
+
+    while (total < dest.size()) {
+        const auto nb = clamp_io_size(dest.size() - total);
+        const auto nb_read = read_file_at(handle, offset + total, dest.data() + total, nb);
+        total += nb_read;
+        // Reads from a file are only short at its end.
+        if (nb_read < nb)
+            break;
+    }
+
+    return total;
+}
+
+void write_at_impl(HANDLE handle, std::uint64_t offset, std::span<const unsigned char> src) {
+    std::size_t total = 0;
+
+    while (total < src.size()) {
+        const auto nb = clamp_io_size(src.size() - total);
+        total += write_file_at(handle, offset + total, src.data() + total, nb);
+    }
+}
+
+// Opens the same file again, without looking up its path.
+File reopen_file(const File& file, const File::OpenOptions& options) {
+    const auto handle = ::ReOpenFile(
+        file.get(), options.get_access(), options.get_share_mode(), options.get_flags()
+    );
+    if (handle == INVALID_HANDLE_VALUE)
+        throw error::windows(GetLastError(), "ReOpenFile");
+    return File{Handle{handle}};
+}
+
+// Returns an invalid handle if the file can't be reopened, e.g. because
+// somebody has opened it without sharing reads.
+Handle reopen_overlapped(HANDLE handle, DWORD access) {
+    const auto reopened = ::ReOpenFile(
+        handle, access, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, FILE_FLAG_OVERLAPPED
+    );
+    if (reopened == INVALID_HANDLE_VALUE)
+        return {};
+    return Handle{reopened};
+}
+
+bool is_larger_than_memory(std::uint64_t nb) {
+    MEMORYSTATUSEX status;
+    std::memset(&status, 0, sizeof(status));
+    status.dwLength = sizeof(status);
+
+    if (!::GlobalMemoryStatusEx(&status))
+        throw error::windows(GetLastError(), "GlobalMemoryStatusEx");
+
+    return nb > status.ullTotalPhys;
+}
+
+bool use_unbuffered(FileCopyOptions::Unbuffered unbuffered, std::uint64_t nb) {
+    switch (unbuffered) {
+        case FileCopyOptions::Unbuffered::Never:
+            return false;
+        case FileCopyOptions::Unbuffered::Always:
+            return true;
+        case FileCopyOptions::Unbuffered::Auto:
+            // Caching such files only evicts everything else.
+            return is_larger_than_memory(nb);
+    }
+    return false;
+}
+
+class FileCopy {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    FileCopy(
+        const File& src,
+        const File& dst,
+        std::uint64_t size,
+        const FileCopyOptions& options,
+        bool unbuffered
+    )
+        : m_src{src},
+          m_dst{dst},
+          m_options{options},
+          m_size{size},
+          // Unbuffered I/O is done in whole sectors.
+          m_sector_size{unbuffered ? std::max(src.get_sector_size(), dst.get_sector_size()) : 1},
+          m_chunk_size{get_chunk_size(options, unbuffered, m_sector_size)} {
+        if (options.queue_depth == 0)
+            throw std::range_error{"Copy queue depth must be positive"};
+
+        const auto numof_chunks = (m_size + m_chunk_size - 1) / m_chunk_size;
+        const auto numof_slots = std::min<std::uint64_t>(
+            std::min<std::size_t>(options.queue_depth, MAXIMUM_WAIT_OBJECTS), numof_chunks
+        );
+        m_slots.reserve(static_cast<std::size_t>(numof_slots));
+        for (std::uint64_t i = 0; i < numof_slots; ++i)
+            m_slots.emplace_back(std::make_unique<Slot>(m_chunk_size));
+    }
+
+    ~FileCopy() {
+        // The kernel might still be using the buffers if the copy has failed.
+        for (auto& slot : m_slots)
+            slot->cancel();
+    }
+
+    FileCopy(const FileCopy&) = delete;
+    FileCopy& operator=(const FileCopy&) = delete;
+
+    FileCopyProgress run() {
+        m_start = Clock::now();
+
+        // Overlapped writes past the end of the file are done synchronously,
+        // so the destination is extended beforehand.
+        m_dst.reserve(m_size);
+        if (m_options.skip_zero_fill)
+            m_dst.set_size_fast(m_size);
+        else
+            m_dst.set_size(m_size);
+
+        for (auto& slot : m_slots)
+            start_read(*slot);
+
+        const auto interval = std::max(m_options.progress_interval, std::chrono::milliseconds{1});
+        auto next_report = m_start + interval;
+
+        while (in_progress()) {
+            if (const auto slot = wait_any(next_report)) {
+                if (slot->reading)
+                    finish_read(*slot);
+                else
+                    finish_write(*slot);
+            }
+
+            const auto now = Clock::now();
+            if (now >= next_report) {
+                if (m_options.on_progress)
+                    m_options.on_progress(get_progress());
+                next_report = now + interval;
+            }
+        }
+
+        // Unbuffered writes may have gone past the end.
+        m_dst.set_size(m_size);
+
+        const auto progress = get_progress();
+        if (m_options.on_progress)
+            m_options.on_progress(progress);
+        return progress;
+    }
+
+private:
+    // A chunk being read, then written.
+    struct Slot {
+        explicit Slot(std::size_t nb) : buffer{nb} {}
+
+        // Can't fail, so that the buffer's never freed while it's in use.
+        void cancel() noexcept {
+            if (handle == NULL)
+                return;
+            ::CancelIoEx(handle, &overlapped);
+            DWORD nb_transferred = 0;
+            ::GetOverlappedResult(handle, &overlapped, &nb_transferred, TRUE);
+            handle = NULL;
+        }
+
+        AlignedBuffer buffer;
+        async::PooledEvent event;
+        OVERLAPPED overlapped;
+        // The handle of the operation in progress, NULL if there's none.
+        HANDLE handle = NULL;
+        bool reading = false;
+        std::uint64_t offset = 0;
+        std::size_t nb = 0;
+#ifdef WINAPI_COMMON_IO_STATS
+        IoStats::Clock::time_point start;
+#endif
+    };
+
+    static std::size_t get_chunk_size(
+        const FileCopyOptions& options, bool unbuffered, std::size_t sector_size
+    ) {
+        if (options.chunk_size == 0)
+            throw std::range_error{"Copy chunk size must be positive"};
+        auto chunk_size = options.chunk_size;
+        if (unbuffered)
+            chunk_size = AlignedBuffer::round_up(AlignedBuffer::round_up(chunk_size), sector_size);
+        // Every chunk is read & written using a single call.
+        async::check_io_size(chunk_size);
+        return chunk_size;
+    }
+
+    FileCopyProgress get_progress() const {
+        FileCopyProgress progress;
+        progress.copied = m_copied;
+        progress.total = m_size;
+        progress.elapsed = Clock::now() - m_start;
+        return progress;
+    }
+
+    void start(Slot& slot, const File& file, bool reading) {
+        slot.overlapped = make_overlapped(slot.offset);
+        slot.overlapped.hEvent = slot.event.get();
+        slot.reading = reading;
+
+        // The part of the last sector past the end is truncated later.
+        const auto nb = static_cast<DWORD>(AlignedBuffer::round_up(slot.nb, m_sector_size));
+
+#ifdef WINAPI_COMMON_IO_STATS
+        slot.start = IoStats::Clock::now();
+#endif
+        BOOL ret = FALSE;
+        if (reading)
+            ret = ::ReadFile(file.get(), slot.buffer.data(), nb, NULL, &slot.overlapped);
+        else
+            ret = ::WriteFile(file.get(), slot.buffer.data(), nb, NULL, &slot.overlapped);
+
+        if (!ret) {
+            const auto ec = GetLastError();
+            if (reading && ec == ERROR_HANDLE_EOF)
+                throw std::runtime_error{"File has shrunk while being copied"};
+            if (ec != ERROR_IO_PENDING)
+                throw error::windows(ec, reading ? "ReadFile" : "WriteFile");
+        }
+        // Whether it's completed right away or not, the event is signalled.
+        slot.handle = file.get();
+    }
+
+    void start_read(Slot& slot) {
+        if (m_next_offset >= m_size)
+            return;
+        slot.offset = m_next_offset;
+        slot.nb = static_cast<std::size_t>(
+            std::min<std::uint64_t>(m_chunk_size, m_size - m_next_offset)
+        );
+        m_next_offset += slot.nb;
+        start(slot, m_src, true);
+    }
+
+    std::size_t finish(Slot& slot) {
+        DWORD nb_transferred = 0;
+        const auto ret =
+            ::GetOverlappedResult(slot.handle, &slot.overlapped, &nb_transferred, TRUE);
+        slot.handle = NULL;
+
+        if (!ret) {
+            const auto ec = GetLastError();
+            if (!slot.reading || ec != ERROR_HANDLE_EOF)
+                throw error::windows(ec, "GetOverlappedResult");
+            nb_transferred = 0;
+        }
+
+#ifdef WINAPI_COMMON_IO_STATS
+        // Only the raw handles are at hand here.
+        const auto latency = IoStats::Clock::now() - slot.start;
+        if (slot.reading)
+            IoStats::global().record_read(slot.nb, nb_transferred, latency);
+        else
+            IoStats::global().record_write(nb_transferred, latency);
+#endif
+        return nb_transferred;
+    }
+
+    void finish_read(Slot& slot) {
+        if (finish(slot) < slot.nb)
+            throw std::runtime_error{"File has shrunk while being copied"};
+        start(slot, m_dst, false);
+    }
+
+    void finish_write(Slot& slot) {
+        finish(slot);
+        m_copied += slot.nb;
+        start_read(slot);
+    }
+
+    bool in_progress() const {
+        return std::any_of(m_slots.begin(), m_slots.end(), [](const auto& slot) {
+            return slot->handle != NULL;
+        });
+    }
+
+    // Returns the slot the operation of which has completed, or NULL on
+    // timeout.
+    Slot* wait_any(Clock::time_point deadline) {
+        std::array<HANDLE, MAXIMUM_WAIT_OBJECTS> events;
+        std::array<Slot*, MAXIMUM_WAIT_OBJECTS> slots;
+        DWORD numof_events = 0;
+
+        for (auto& slot : m_slots) {
+            if (slot->handle == NULL)
+                continue;
+            events[numof_events] = slot->event.get();
+            slots[numof_events] = slot.get();
+            ++numof_events;
+        }
+
+        const auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - Clock::now()
+        );
+        const auto ret = ::WaitForMultipleObjects(
+            numof_events, events.data(), FALSE, async::to_timeout(timeout)
+        );
+
+        if (ret == WAIT_TIMEOUT)
+            return nullptr;
+        if (ret >= WAIT_OBJECT_0 + numof_events)
+            throw error::windows(GetLastError(), "WaitForMultipleObjects");
+        return slots[ret - WAIT_OBJECT_0];
+    }
+
+    const File& m_src;
+    const File& m_dst;
+    const FileCopyOptions& m_options;
+
+    const std::uint64_t m_size;
+    const std::size_t m_sector_size;
+    const std::size_t m_chunk_size;
+
+    Clock::time_point m_start;
+    std::uint64_t m_next_offset = 0;
+    std::uint64_t m_copied = 0;
+
+    // Every slot reads a chunk, writes it & moves on to the next one, until
+    // there're no chunks left.
+    std::vector<std::unique_ptr<Slot>> m_slots;
+};
+
+template <typename Path>
+FileCopyProgress copy_file(
+    const Path& src_path, const Path& dst_path, const FileCopyOptions& options
+) {
+    auto src_options = File::OpenOptions::read().sequential_scan().overlapped();
+    auto dst_options = File::OpenOptions::write().overlapped();
+    src_options.inheritable(false);
+    dst_options.inheritable(false);
+
+    // Only Auto needs the size of the source to decide.
+    const auto always_unbuffered = options.unbuffered == FileCopyOptions::Unbuffered::Always;
+    if (always_unbuffered)
+        src_options.no_buffering();
+
+    auto src = File::open(src_path, src_options);
+    const auto size = get_file_size(src.get());
+    const auto unbuffered = use_unbuffered(options.unbuffered, size);
+
+    if (unbuffered) {
+        dst_options.no_buffering();
+        if (!always_unbuffered) {
+            src_options.no_buffering();
+            src = reopen_file(src, src_options);
+        }
+    }
+
+    const auto dst = File::open(dst_path, dst_options);
+    return FileCopy{src, dst, size, options, unbuffered}.run();
+}
+
 } // namespace
 
+double FileCopyProgress::get_throughput() const {
+    const auto seconds = std::chrono::duration<double>{elapsed}.count();
+    if (seconds <= 0)
+        return 0;
+    return static_cast<double>(copied) / seconds;
+}
+
+File::CopyProgress File::copy(
+    std::string_view src, std::string_view dst, const CopyOptions& options
+) {
+    return copy_file(src, dst, options);
+}
+
+File::CopyProgress File::copy(
+    std::wstring_view src, std::wstring_view dst, const CopyOptions& options
+) {
+    return copy_file(src, dst, options);
+}
+
+File::CopyProgress File::copy(
+    const CanonicalPath& src, const CanonicalPath& dst, const CopyOptions& options
+) {
+    return copy_file(src, dst, options);
+}
+
+std::size_t File::default_thread_count() {
+    return parallel::default_thread_count();
+}
+
+std::size_t File::default_stat_thread_count() {
+    return default_thread_count();
+}
+
+File::Stats File::stat_many(std::span<const std::string> paths, std::size_t thread_count) {
+    return stat_many_impl(paths, thread_count);
+}
+
+File::Stats File::stat_many(std::span<const std::wstring> paths, std::size_t thread_count) {
+    return stat_many_impl(paths, thread_count);
+}
+
+File::Stats File::stat_many(std::span<const CanonicalPath> paths, std::size_t thread_count) {
+    return stat_many_impl(paths, thread_count);
+}
+
+File::OpenOptions File::OpenOptions::read() {
+    return {GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING};
+}
+
+File::OpenOptions File::OpenOptions::read_attributes() {
+    return {FILE_READ_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE, OPEN_EXISTING};
+}
+
+File::OpenOptions File::OpenOptions::write() {
+    return {GENERIC_WRITE, FILE_SHARE_READ, OPEN_ALWAYS};
+}
+
+File::OpenOptions File::OpenOptions::list_directory() {
+    OpenOptions options{
+        FILE_LIST_DIRECTORY | FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        OPEN_EXISTING
+    };
+    // Directories can't be opened without this flag.
+    options.m_flags |= FILE_FLAG_BACKUP_SEMANTICS;
+    return options;
+}
+
+File File::open(std::string_view path, const OpenOptions& options) {
+    return open_file(to_system_path(path), options);
+}
+
+File File::open(std::wstring_view path, const OpenOptions& options) {
+    return open_file(to_system_path(path), options);
+}
+
+File File::open(const CanonicalPath& path, const OpenOptions& options) {
+    return open_file(to_system_path(path), options);
+}
+
 File File::open_r(std::string_view path) {
-    return open_file(to_system_path(path), CreateFileParams::read());
+    return open_file(to_system_path(path), OpenOptions::read());
+}
+
+File File::open_r(std::wstring_view path) {
+    return open_file(to_system_path(path), OpenOptions::read());
 }
 
 File File::open_r(const CanonicalPath& path) {
-    return open_file(to_system_path(path), CreateFileParams::read());
+    return open_file(to_system_path(path), OpenOptions::read());
 }
 
 File File::open_read_attributes(std::string_view path) {
-    return open_file(to_system_path(path), CreateFileParams::read_attributes());
+    return open_file(to_system_path(path), OpenOptions::read_attributes());
+}
+
+File File::open_read_attributes(std::wstring_view path) {
+    return open_file(to_system_path(path), OpenOptions::read_attributes());
 }
 
 File File::open_read_attributes(const CanonicalPath& path) {
-    return open_file(to_system_path(path), CreateFileParams::read_attributes());
+    return open_file(to_system_path(path), OpenOptions::read_attributes());
 }
 
 File File::open_w(std::string_view path) {
-    return open_file(to_system_path(path), CreateFileParams::write());
+    return open_file(to_system_path(path), OpenOptions::write());
+}
+
+File File::open_w(std::wstring_view path) {
+    return open_file(to_system_path(path), OpenOptions::write());
 }
 
 File File::open_w(const CanonicalPath& path) {
-    return open_file(to_system_path(path), CreateFileParams::write());
+    return open_file(to_system_path(path), OpenOptions::write());
+}
+
+File File::open_r_async(std::string_view path) {
+    return open_file(to_system_path(path), OpenOptions::read().overlapped());
+}
+
+File File::open_r_async(std::wstring_view path) {
+    return open_file(to_system_path(path), OpenOptions::read().overlapped());
+}
+
+File File::open_r_async(const CanonicalPath& path) {
+    return open_file(to_system_path(path), OpenOptions::read().overlapped());
+}
+
+File File::open_w_async(std::string_view path) {
+    return open_file(to_system_path(path), OpenOptions::write().overlapped());
+}
+
+File File::open_w_async(std::wstring_view path) {
+    return open_file(to_system_path(path), OpenOptions::write().overlapped());
+}
+
+File File::open_w_async(const CanonicalPath& path) {
+    return open_file(to_system_path(path), OpenOptions::write().overlapped());
+}
+
+MappedView File::map_r(std::string_view path) {
+    return open_r(path).map_r();
+}
+
+MappedView File::map_r(std::wstring_view path) {
+    return open_r(path).map_r();
+}
+
+MappedView File::map_r(const CanonicalPath& path) {
+    return open_r(path).map_r();
 }
 
 void File::remove(std::string_view path) {
     remove_file(to_system_path(path));
 }
 
+void File::remove(std::wstring_view path) {
+    remove_file(to_system_path(path));
+}
+
 void File::remove(const CanonicalPath& path) {
     remove_file(to_system_path(path));
 }
 
 std::size_t File::get_size() const {
-    LARGE_INTEGER size;
+    const auto size = get_file_size(get());
+    if (size > std::numeric_limits<std::size_t>::max())
+        throw std::runtime_error{"invalid file size"};
+    return static_cast<std::size_t>(size);
+}
 
-    if (!GetFileSizeEx(get(), &size))
-        throw error::windows(GetLastError(), "GetFileSizeEx");
+void File::reserve(std::uint64_t nb) const {
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize = to_large_integer(nb);
 
-    if (size.QuadPart < 0 ||
-        static_cast<ULONGLONG>(size.QuadPart) > std::numeric_limits<std::size_t>::max())
-        throw std::runtime_error{"invalid file size"};
-    return static_cast<std::size_t>(size.QuadPart);
+    if (!SetFileInformationByHandle(get(), FileAllocationInfo, &info, sizeof(info)))
+        throw error::windows(GetLastError(), "SetFileInformationByHandle");
+}
+
+void File::set_size(std::uint64_t nb) const {
+    FILE_END_OF_FILE_INFO info;
+    info.EndOfFile = to_large_integer(nb);
+
+    if (!SetFileInformationByHandle(get(), FileEndOfFileInfo, &info, sizeof(info)))
+        throw error::windows(GetLastError(), "SetFileInformationByHandle");
+}
+
+bool File::set_size_fast(std::uint64_t nb) const {
+    // SetFileValidData can only move the valid data length forward.
+    const auto extends = nb > get_file_size(get());
+    set_size(nb);
+
+    if (!extends || !enable_manage_volume_privilege())
+        return false;
+
+    if (!SetFileValidData(get(), to_large_integer(nb).QuadPart)) {
+        const auto ec = GetLastError();
+        if (ec == ERROR_PRIVILEGE_NOT_HELD)
+            return false;
+        throw error::windows(ec, "SetFileValidData");
+    }
+    return true;
+}
+
+void File::set_sparse(bool sparse) const {
+    FILE_SET_SPARSE_BUFFER buffer;
+    buffer.SetSparse = sparse ? TRUE : FALSE;
+    DWORD nb = 0;
+
+    const auto ret =
+        ::DeviceIoControl(get(), FSCTL_SET_SPARSE, &buffer, sizeof(buffer), NULL, 0, &nb, NULL);
+
+    if (!ret) {
+        throw error::windows(GetLastError(), "DeviceIoControl");
+    }
+}
+
+void File::zero_range(std::uint64_t offset, std::uint64_t nb) const {
+    if (nb > std::numeric_limits<std::uint64_t>::max() - offset)
+        throw std::range_error{"File range is too large"};
+
+    FILE_ZERO_DATA_INFORMATION info;
+    info.FileOffset = to_large_integer(offset);
+    info.BeyondFinalZero = to_large_integer(offset + nb);
+    DWORD nb_returned = 0;
+
+    const auto ret = ::DeviceIoControl(
+        get(), FSCTL_SET_ZERO_DATA, &info, sizeof(info), NULL, 0, &nb_returned, NULL
+    );
+
+    if (!ret) {
+        throw error::windows(GetLastError(), "DeviceIoControl");
+    }
+}
+
+Buffer File::read_all() const {
+    // Keep individual reads reasonably sized, ReadFile can't read more than
+    // 4 GiB at once anyway.
+    static constexpr std::size_t max_read_size = 64 * 1024 * 1024;
+
+    const auto expected_size = get_size();
+
+    Buffer buffer;
+    buffer.resize(expected_size);
+    std::size_t offset = 0;
+
+    while (offset < expected_size) {
+        const auto nb = std::min(expected_size - offset, max_read_size);
+        std::size_t nb_read = 0;
+        const auto next = read_chunk(buffer.data() + offset, nb, nb_read);
+        offset += nb_read;
+
+        if (!next) {
+            // The file has shrunk, or we haven't started at the beginning.
+            buffer.resize(offset);
+            return buffer;
+        }
+    }
+
+    // Make sure we're at the end without growing the buffer, which would
+    // reallocate it.
+    Buffer chunk;
+    while (read_chunk(chunk)) {
+        // The file has grown since we've queried its size.
+        buffer.add(chunk);
+    }
+    return buffer;
+}
+
+std::size_t File::read_at(std::uint64_t offset, std::span<unsigned char> dest) const {
+#ifdef WINAPI_COMMON_IO_STATS
+    const auto start = IoStats::Clock::now();
+    const auto nb_read = read_at_impl(get(), offset, dest);
+    record_read(dest.size(), nb_read, IoStats::Clock::now() - start);
+    return nb_read;
+#else
+    return read_at_impl(get(), offset, dest);
+#endif
+}
+
+void File::write_at(std::uint64_t offset, std::span<const unsigned char> src) const {
+#ifdef WINAPI_COMMON_IO_STATS
+    const auto start = IoStats::Clock::now();
+    write_at_impl(get(), offset, src);
+    record_write(src.size(), IoStats::Clock::now() - start);
+#else
+    write_at_impl(get(), offset, src);
+#endif
+}
+
+Buffer File::read_all_parallel(std::size_t thread_count) const {
+    // Smaller files aren't worth splitting.
+    static constexpr std::size_t min_part_size = 4 * 1024 * 1024;
+    // Keep the parts aligned for the underlying storage.
+    static constexpr std::size_t part_alignment = 64 * 1024;
+
+    const auto file_size = get_file_size(get());
+    if (file_size > std::numeric_limits<std::size_t>::max())
+        throw std::range_error{"File is too large to be read into memory"};
+    const auto size = static_cast<std::size_t>(file_size);
+
+    Buffer buffer;
+    buffer.resize(size);
+    if (size == 0)
+        return buffer;
+
+    const auto max_parts = (size + min_part_size - 1) / min_part_size;
+    const auto numof_parts = std::max<std::size_t>(1, std::min(thread_count, max_parts));
+    auto part_size = (size + numof_parts - 1) / numof_parts;
+    part_size = (part_size + part_alignment - 1) / part_alignment * part_alignment;
+
+    // Reads using this handle would be done one at a time if it's
+    // synchronous, and would move its file position.
+    const auto reopened = reopen_overlapped(get(), GENERIC_READ);
+    const auto handle = reopened.is_valid() ? reopened.get() : get();
+
+    // Number of bytes actually read into every part.
+    std::vector<std::size_t> nb_read(numof_parts, 0);
+
+    parallel::for_each(numof_parts, 1, numof_parts, [&](std::uint64_t i) {
+        const auto j = static_cast<std::size_t>(i);
+        const auto offset = std::min(size, j * part_size);
+        const auto nb = std::min(size - offset, part_size);
+#ifdef WINAPI_COMMON_IO_STATS
+        const auto start = IoStats::Clock::now();
+        nb_read[j] = read_at_impl(handle, offset, {buffer.data() + offset, nb});
+        record_read(nb, nb_read[j], IoStats::Clock::now() - start);
+#else
+        nb_read[j] = read_at_impl(handle, offset, {buffer.data() + offset, nb});
+#endif
+    });
+
+    // The file has shrunk since we've queried its size: keep everything up
+    // to the first short read.
+    for (std::size_t j = 0; j < numof_parts; ++j) {
+        const auto offset = std::min(size, j * part_size);
+        const auto nb = std::min(size - offset, part_size);
+        if (nb_read[j] < nb) {
+            buffer.resize(offset + nb_read[j]);
+            break;
+        }
+    }
+    return buffer;
+}
+
+MappedView File::map_r() const {
+    return MappedView::map_r(*this, 0, get_size());
+}
+
+MappedView File::map_r(std::uint64_t offset, std::size_t nb) const {
+    const auto size = get_size();
+    if (offset > size || nb > size - offset)
+        throw std::range_error{"Mapped range is outside of the file"};
+    return MappedView::map_r(*this, offset, nb);
+}
+
+std::size_t File::get_sector_size() const {
+    FILE_STORAGE_INFO info;
+
+    if (!GetFileInformationByHandleEx(get(), FileStorageInfo, &info, sizeof(info)))
+        throw error::windows(GetLastError(), "GetFileInformationByHandleEx");
+
+    return info.PhysicalBytesPerSectorForPerformance;
 }
 
 bool operator==(const FILE_ID_128& a, const FILE_ID_128& b) {
@@ -3,17 +3,32 @@
 // For details, see https://github.com/egor-tensin/winapi-common.
 // Distributed under the MIT License.
 
+#include "unicode.hpp"
+
+#include <winapi/async_io.hpp>
 #include <winapi/buffer.hpp>
+#include <winapi/buffer_pool.hpp>
+#include <winapi/chunked_buffer.hpp>
+#include <winapi/coro.hpp>
 #include <winapi/error.hpp>
 #include <winapi/handle.hpp>
+#include <winapi/uninit_buffer.hpp>
 #include <winapi/utils.hpp>
 
 #include <windows.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <cstdint>
+#include <format>
 #include <limits>
+#include <memory>
+#include <optional>
+#include <span>
 #include <stdexcept>
+#include <string>
+#include <string_view>
 #include <utility>
 
 namespace winapi {
@@ -31,10 +46,268 @@ bool is_std_handle(HANDLE handle) {
            handle == ::GetStdHandle(STD_ERROR_HANDLE);
 }
 
+Handle::Kind query_kind(HANDLE handle) {
+    switch (::GetFileType(handle)) {
+        case FILE_TYPE_DISK:
+            return Handle::Kind::Disk;
+        case FILE_TYPE_PIPE:
+            return Handle::Kind::Pipe;
+        case FILE_TYPE_CHAR: {
+            DWORD mode = 0;
+            if (::GetConsoleMode(handle, &mode))
+                return Handle::Kind::Console;
+            return Handle::Kind::Char;
+        }
+        default:
+            return Handle::Kind::Unknown;
+    }
+}
+
+Handle::ChunkSize default_chunk_size(Handle::Kind kind) {
+    // Files are usually read in bulk.
+    if (kind == Handle::Kind::Disk)
+        return Handle::ChunkSize::adaptive(Handle::max_chunk_size);
+    return Handle::ChunkSize::fixed(Handle::max_chunk_size);
+}
+
+std::size_t read_size(HANDLE handle, Handle::Kind kind, std::size_t nb, bool last_full) {
+    // Only bother peeking if the last read suggests there's more data.
+    if (kind != Handle::Kind::Pipe || !last_full)
+        return nb;
+
+    // If more data has piled up in the pipe, read all of it at once.
+    DWORD available = 0;
+    if (!::PeekNamedPipe(handle, NULL, 0, NULL, &available, NULL))
+        // Let ReadFile report errors & the end of data.
+        return nb;
+    return std::clamp<std::size_t>(available, nb, std::max(nb, Handle::ChunkSize::default_max));
+}
+
+void write_console(HANDLE handle, std::string_view src) {
+    // WriteConsoleW displays the text correctly regardless of the console's
+    // code page.
+    const auto text = unicode::widen(src);
+
+    std::wstring_view remaining{text};
+    while (!remaining.empty()) {
+        const auto nch = static_cast<DWORD>(
+            std::min<std::size_t>(remaining.size(), std::numeric_limits<DWORD>::max())
+        );
+        DWORD nch_written = 0;
+
+        if (!::WriteConsoleW(handle, remaining.data(), nch, &nch_written, NULL)) {
+            throw error::windows(GetLastError(), "WriteConsoleW");
+        }
+
+        if (nch_written == 0) {
+            throw std::runtime_error{"WriteConsoleW didn't write anything"};
+        }
+
+        remaining.remove_prefix(nch_written);
+    }
+}
+
+std::size_t write_file_some(HANDLE handle, const void* data, std::size_t nb) {
+    DWORD nb_written = 0;
+
+    if (nb > std::numeric_limits<DWORD>::max())
+        throw std::range_error{"Write buffer is too large"};
+    const auto ret = ::WriteFile(handle, data, static_cast<DWORD>(nb), &nb_written, NULL);
+
+    if (!ret) {
+        throw error::windows(GetLastError(), "WriteFile");
+    }
+
+    return nb_written;
+}
+
+void write_file(HANDLE handle, const void* data, std::size_t nb) {
+    const auto nb_written = write_file_some(handle, data, nb);
+
+    if (nb != nb_written) {
+        throw write_file_incomplete(nb, nb_written);
+    }
+}
+
+bool read_file(HANDLE handle, void* dest, std::size_t nb, std::size_t& nb_read) {
+    DWORD dw_nb_read = 0;
+
+    if (nb > std::numeric_limits<DWORD>::max())
+        throw std::range_error{"Read buffer is too large"};
+    const auto ret = ::ReadFile(handle, dest, static_cast<DWORD>(nb), &dw_nb_read, NULL);
+
+    nb_read = dw_nb_read;
+
+    if (ret) {
+        return nb_read != 0;
+    }
+
+    const auto ec = GetLastError();
+
+    switch (ec) {
+        case ERROR_BROKEN_PIPE:
+            // We've been reading from an anonymous pipe, and it's been closed.
+            return false;
+        default:
+            throw error::windows(ec, "ReadFile");
+    }
+}
+
+void update_chunk_size(Handle::ChunkSize& chunk_size, std::size_t nb_read) {
+    // A read that's been enlarged by read_size() only counts for as much as
+    // the policy asked for.
+    const auto nb = chunk_size.get();
+    chunk_size.update(nb, std::min(nb_read, nb));
+}
+
+/**
+ * Per-thread scratch space to read into.
+ * Buffer zero-fills whatever it grows by, so reading into it directly would
+ * write every byte twice, and a short read on a pipe would still pay for
+ * zero-filling the whole chunk.
+ * Only use it in functions that don't call back into user code.
+ */
+UninitBuffer& scratch_buffer(std::size_t nb) {
+    thread_local UninitBuffer buffer;
+    buffer.resize(nb);
+    return buffer;
+}
+
+bool read_chunk_impl(const Handle& handle, Buffer& buffer, std::size_t chunk_size) {
+    auto& scratch = scratch_buffer(chunk_size);
+    std::size_t nb_read = 0;
+    const auto next = handle.read_chunk(scratch.data(), chunk_size, nb_read);
+    buffer.assign(scratch.data(), scratch.data() + nb_read);
+    return next;
+}
+
+Buffer read_impl(const Handle& handle, Handle::ChunkSize& chunk_size) {
+    const auto handle_kind = handle.kind();
+    UninitBuffer buffer;
+    bool last_full = false;
+
+    while (true) {
+        // Read straight into the end of the buffer.
+        const auto offset = buffer.size();
+        const auto nb = read_size(handle.get(), handle_kind, chunk_size.get(), last_full);
+        buffer.resize(offset + nb);
+        std::size_t nb_read = 0;
+        const auto next = handle.read_chunk(buffer.data() + offset, nb, nb_read);
+        buffer.resize(offset + nb_read);
+        last_full = nb_read == nb;
+        update_chunk_size(chunk_size, nb_read);
+
+        if (!next) {
+            break;
+        }
+    }
+
+    // The only copy of the data there is.
+    return Buffer(buffer.data(), buffer.size());
+}
+
+void read_each_impl(
+    const Handle& handle,
+    Handle::ChunkSize& chunk_size,
+    const Handle::ChunkCallback& callback
+) {
+    const auto handle_kind = handle.kind();
+    // Not the per-thread scratch buffer: the callback might read from another
+    // handle.
+    UninitBuffer buffer;
+    bool last_full = false;
+
+    while (true) {
+        const auto nb = read_size(handle.get(), handle_kind, chunk_size.get(), last_full);
+        // Adaptive chunks only ever grow the buffer.
+        if (buffer.size() < nb)
+            buffer.resize(nb);
+        std::size_t nb_read = 0;
+        const auto next = handle.read_chunk(buffer.data(), nb, nb_read);
+        last_full = nb_read == nb;
+        update_chunk_size(chunk_size, nb_read);
+
+        if (nb_read != 0) {
+            callback(std::span<const unsigned char>{buffer.data(), nb_read});
+        }
+
+        if (!next) {
+            break;
+        }
+    }
+}
+
+template <typename NewChunk>
+ChunkedBuffer read_chunked_impl(
+    const Handle& handle,
+    Handle::ChunkSize& chunk_size,
+    NewChunk&& new_chunk
+) {
+    ChunkedBuffer buffer;
+    // Short reads are appended to the same chunk until it's full, so that
+    // reading small pieces doesn't waste a whole chunk on each of them.
+    auto chunk = new_chunk(chunk_size.get());
+
+    while (true) {
+        if (chunk.size() == chunk.capacity()) {
+            buffer.add(std::move(chunk));
+            chunk = new_chunk(chunk_size.get());
+        }
+
+        const auto offset = chunk.size();
+        const auto policy_nb = chunk_size.get();
+        const auto nb = std::min(policy_nb, chunk.capacity() - offset);
+        auto& scratch = scratch_buffer(nb);
+        std::size_t nb_read = 0;
+        const auto next = handle.read_chunk(scratch.data(), nb, nb_read);
+        chunk.insert(chunk.end(), scratch.data(), scratch.data() + nb_read);
+        // A read that's been cut short to fit into the chunk says nothing
+        // about the policy if it came back full.
+        if (nb == policy_nb || nb_read < nb)
+            chunk_size.update(policy_nb, nb_read);
+
+        if (!next) {
+            break;
+        }
+    }
+
+    buffer.add(std::move(chunk));
+    return buffer;
+}
+
+Buffer new_chunk(std::size_t nb) {
+    Buffer chunk;
+    chunk.reserve(nb);
+    return chunk;
+}
+
 } // namespace
 
 Handle::Handle(HANDLE impl) : m_impl{impl} {}
 
+Handle::Handle(Handle&& other) noexcept
+    : m_impl{std::move(other.m_impl)},
+      m_chunk_size{std::exchange(other.m_chunk_size, std::nullopt)},
+      m_next_chunk_size{other.m_next_chunk_size.exchange(0)},
+      m_kind{other.m_kind.exchange(std::nullopt)} {
+#ifdef WINAPI_COMMON_IO_STATS
+    m_io_stats = std::move(other.m_io_stats);
+#endif
+}
+
+Handle& Handle::operator=(Handle&& other) noexcept {
+    if (this != &other) {
+        m_impl = std::move(other.m_impl);
+        m_chunk_size = std::exchange(other.m_chunk_size, std::nullopt);
+        m_next_chunk_size = other.m_next_chunk_size.exchange(0);
+        m_kind = other.m_kind.exchange(std::nullopt);
+#ifdef WINAPI_COMMON_IO_STATS
+        m_io_stats = std::move(other.m_io_stats);
+#endif
+    }
+    return *this;
+}
+
 bool Handle::is_valid() const {
     return m_impl && is_valid(m_impl.get());
 }
@@ -45,6 +318,23 @@ bool Handle::is_valid(HANDLE handle) {
 
 void Handle::close() {
     m_impl.reset();
+    m_kind = std::nullopt;
+}
+
+Handle::Kind Handle::kind() const {
+    if (const auto kind = m_kind.load())
+        return *kind;
+    // Racing threads would just compute the same thing.
+    const auto kind = query_kind(m_impl.get());
+    m_kind = kind;
+    return kind;
+}
+
+Handle::ChunkSize Handle::get_chunk_size() const {
+    auto chunk_size = m_chunk_size ? *m_chunk_size : default_chunk_size(kind());
+    if (const auto next = m_next_chunk_size.load())
+        chunk_size.set(next);
+    return chunk_size;
 }
 
 bool Handle::is_std() const {
@@ -64,66 +354,187 @@ Handle Handle::std_err() {
 }
 
 bool Handle::read_chunk(Buffer& buffer) const {
-    buffer.resize(max_chunk_size);
-    DWORD nb_read = 0;
-
-    if (buffer.size() > std::numeric_limits<DWORD>::max())
-        throw std::range_error{"Read buffer is too large"};
-    const auto ret =
-        ::ReadFile(m_impl.get(), buffer.data(), static_cast<DWORD>(buffer.size()), &nb_read, NULL);
-
-    buffer.resize(nb_read);
+    auto chunk_size = get_chunk_size();
+    const auto next = read_chunk(buffer, chunk_size);
+    save_chunk_size(chunk_size);
+    return next;
+}
 
-    if (ret) {
-        return nb_read != 0;
-    }
+bool Handle::read_chunk(Buffer& buffer, ChunkSize& chunk_size) const {
+    const auto nb = chunk_size.get();
+    const auto next = read_chunk_impl(*this, buffer, nb);
+    chunk_size.update(nb, buffer.size());
+    return next;
+}
 
-    const auto ec = GetLastError();
+bool Handle::read_chunk(BufferPool& pool, PooledBuffer& buffer) const {
+    if (!buffer.is_borrowed())
+        buffer = pool.borrow();
+    return read_chunk_impl(*this, *buffer, pool.chunk_size());
+}
 
-    switch (ec) {
-        case ERROR_BROKEN_PIPE:
-            // We've been reading from an anonymous pipe, and it's been closed.
-            return false;
-        default:
-            throw error::windows(ec, "ReadFile");
-    }
+bool Handle::read_chunk(void* dest, std::size_t nb, std::size_t& nb_read) const {
+    // Every synchronous read goes through here.
+#ifdef WINAPI_COMMON_IO_STATS
+    const auto start = IoStats::Clock::now();
+    const auto next = read_file(m_impl.get(), dest, nb, nb_read);
+    record_read(nb, nb_read, IoStats::Clock::now() - start);
+    return next;
+#else
+    return read_file(m_impl.get(), dest, nb, nb_read);
+#endif
 }
 
 Buffer Handle::read() const {
-    Buffer buffer;
+    auto chunk_size = get_chunk_size();
+    auto buffer = read_impl(*this, chunk_size);
+    save_chunk_size(chunk_size);
+    return buffer;
+}
 
-    while (true) {
-        Buffer chunk;
-        const auto next = read_chunk(chunk);
-        buffer.add(chunk);
+Buffer Handle::read(ChunkSize chunk_size) const {
+    return read_impl(*this, chunk_size);
+}
 
-        if (!next) {
-            break;
-        }
-    }
+void Handle::read_each(const ChunkCallback& callback) const {
+    auto chunk_size = get_chunk_size();
+    read_each_impl(*this, chunk_size, callback);
+    save_chunk_size(chunk_size);
+}
+
+void Handle::read_each(ChunkSize chunk_size, const ChunkCallback& callback) const {
+    read_each_impl(*this, chunk_size, callback);
+}
 
+ChunkedBuffer Handle::read_chunked() const {
+    auto chunk_size = get_chunk_size();
+    auto buffer = read_chunked_impl(*this, chunk_size, new_chunk);
+    save_chunk_size(chunk_size);
     return buffer;
 }
 
+ChunkedBuffer Handle::read_chunked(ChunkSize chunk_size) const {
+    return read_chunked_impl(*this, chunk_size, new_chunk);
+}
+
+ChunkedBuffer Handle::read_chunked(BufferPool& pool) const {
+    auto chunk_size = ChunkSize::fixed(pool.chunk_size());
+    return read_chunked_impl(*this, chunk_size, [&pool](std::size_t) {
+        return pool.acquire();
+    });
+}
+
 void Handle::write(const void* data, std::size_t nb) const {
-    DWORD nb_written = 0;
+    // Every synchronous write goes through here.
+#ifdef WINAPI_COMMON_IO_STATS
+    const auto start = IoStats::Clock::now();
+    write_file(m_impl.get(), data, nb);
+    record_write(nb, IoStats::Clock::now() - start);
+#else
+    write_file(m_impl.get(), data, nb);
+#endif
+}
 
-    if (nb > std::numeric_limits<DWORD>::max())
-        throw std::range_error{"Write buffer is too large"};
-    const auto ret = ::WriteFile(m_impl.get(), data, static_cast<DWORD>(nb), &nb_written, NULL);
+std::size_t Handle::write_some(const void* data, std::size_t nb) const {
+#ifdef WINAPI_COMMON_IO_STATS
+    const auto start = IoStats::Clock::now();
+    const auto nb_written = write_file_some(m_impl.get(), data, nb);
+    record_write(nb_written, IoStats::Clock::now() - start);
+    return nb_written;
+#else
+    return write_file_some(m_impl.get(), data, nb);
+#endif
+}
 
-    if (!ret) {
-        throw error::windows(GetLastError(), "WriteFile");
+void Handle::write(const Buffer& buffer) const {
+    write(buffer.data(), buffer.size());
+}
+
+void Handle::write_text(std::string_view src) const {
+    if (kind() != Kind::Console) {
+        write(src);
+        return;
     }
+#ifdef WINAPI_COMMON_IO_STATS
+    const auto start = IoStats::Clock::now();
+    write_console(m_impl.get(), src);
+    record_write(src.size(), IoStats::Clock::now() - start);
+#else
+    write_console(m_impl.get(), src);
+#endif
+}
 
-    if (nb != nb_written) {
-        throw write_file_incomplete(nb, nb_written);
+void Handle::write(std::span<const std::span<const std::byte>> pieces) const {
+    Buffer staging;
+
+    const auto flush = [this, &staging]() {
+        if (staging.empty())
+            return;
+        write(staging);
+        staging.clear();
+    };
+
+    for (const auto& piece : pieces) {
+        if (piece.size() >= max_gather_size) {
+            // Preserve the order.
+            flush();
+            write(piece.data(), piece.size());
+            continue;
+        }
+
+        if (staging.size() + piece.size() > max_gather_size)
+            flush();
+        if (staging.capacity() == 0)
+            staging.reserve(max_gather_size);
+
+        staging.add(piece.data(), piece.size());
     }
+
+    flush();
 }
 
-void Handle::write(const Buffer& buffer) const {
-    write(buffer.data(), buffer.size());
+AsyncIo Handle::async_read(std::size_t nb, std::uint64_t offset) const {
+    return AsyncIo::read(get(), nb, offset);
+}
+
+AsyncIo Handle::async_write(Buffer buffer, std::uint64_t offset) const {
+    return AsyncIo::write(get(), std::move(buffer), offset);
+}
+
+coro::ReadChunk Handle::async_read_chunk(std::size_t nb, std::uint64_t offset) const {
+    return coro::ReadChunk{async_read(nb, offset)};
+}
+
+#ifdef WINAPI_COMMON_IO_STATS
+IoStats::Snapshot Handle::get_io_stats() const {
+    if (const auto stats = m_io_stats.get())
+        return stats->snapshot();
+    return {};
+}
+
+void Handle::record_read(
+    std::size_t nb, std::size_t nb_read, IoStats::Clock::duration latency
+) const {
+    IoStats::global().record_read(nb, nb_read, latency);
+    m_io_stats.get_or_create().record_read(nb, nb_read, latency);
+}
+
+void Handle::record_write(std::size_t nb, IoStats::Clock::duration latency) const {
+    IoStats::global().record_write(nb, latency);
+    m_io_stats.get_or_create().record_write(nb, latency);
+}
+
+IoStats& Handle::LazyIoStats::get_or_create() {
+    if (const auto stats = m_stats.load())
+        return *stats;
+    auto stats = std::make_unique<IoStats>();
+    IoStats* expected = nullptr;
+    // Another thread might have beaten us to it.
+    if (m_stats.compare_exchange_strong(expected, stats.get()))
+        return *stats.release();
+    return *expected;
 }
+#endif
 
 void Handle::inherit(bool yes) const {
     if (!::SetHandleInformation(m_impl.get(), HANDLE_FLAG_INHERIT, yes ? 1 : 0)) {
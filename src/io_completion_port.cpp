@@ -0,0 +1,323 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "async.hpp"
+#include "parallel.hpp"
+
+#include <winapi/buffer.hpp>
+#include <winapi/error.hpp>
+#include <winapi/handle.hpp>
+#include <winapi/io_completion_port.hpp>
+#include <winapi/io_stats.hpp>
+
+#include <windows.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace winapi {
+namespace {
+
+// Completion keys.
+constexpr ULONG_PTR io_key = 0;
+constexpr ULONG_PTR task_key = 1;
+constexpr ULONG_PTR quit_key = 2;
+
+Handle create_port(std::size_t thread_count) {
+    if (thread_count == 0)
+        throw std::range_error{"Completion port needs at least one thread"};
+    if (thread_count > std::numeric_limits<DWORD>::max())
+        throw std::range_error{"Too many completion port threads"};
+
+    const auto port = ::CreateIoCompletionPort(
+        INVALID_HANDLE_VALUE, NULL, 0, static_cast<DWORD>(thread_count)
+    );
+
+    if (port == NULL) {
+        throw error::windows(GetLastError(), "CreateIoCompletionPort");
+    }
+
+    return Handle{port};
+}
+
+class PendingGuard {
+public:
+    explicit PendingGuard(std::atomic<std::size_t>& pending) : m_pending{pending} {}
+
+    ~PendingGuard() {
+        --m_pending;
+    }
+
+    PendingGuard(const PendingGuard&) = delete;
+    PendingGuard& operator=(const PendingGuard&) = delete;
+
+private:
+    std::atomic<std::size_t>& m_pending;
+};
+
+} // namespace
+
+struct IoCompletionPort::Operation : OVERLAPPED {
+    explicit Operation(std::uint64_t offset = 0) {
+        std::memset(static_cast<OVERLAPPED*>(this), 0, sizeof(OVERLAPPED));
+        Offset = static_cast<DWORD>(offset);
+        OffsetHigh = static_cast<DWORD>(offset >> 32);
+    }
+
+    HANDLE handle = NULL;
+    bool reading = false;
+    // Set if the operation has failed before it could start.
+    DWORD error = ERROR_SUCCESS;
+    Buffer buffer;
+    Callback callback;
+    Task task;
+#ifdef WINAPI_COMMON_IO_STATS
+    IoStats::Clock::time_point start = IoStats::Clock::now();
+#endif
+};
+
+std::size_t IoCompletionPort::default_thread_count() {
+    return parallel::default_thread_count();
+}
+
+IoCompletionPort::IoCompletionPort(std::size_t thread_count) : m_port{create_port(thread_count)} {
+    m_workers.reserve(thread_count);
+    try {
+        for (std::size_t i = 0; i < thread_count; ++i)
+            m_workers.emplace_back([this]() { run(); });
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+IoCompletionPort::~IoCompletionPort() {
+    try {
+        stop();
+    } catch (...) {
+    }
+}
+
+void IoCompletionPort::associate(const Handle& handle) const {
+    const auto port = ::CreateIoCompletionPort(handle.get(), get(), io_key, 0);
+
+    if (port != get()) {
+        throw error::windows(GetLastError(), "CreateIoCompletionPort");
+    }
+}
+
+void IoCompletionPort::async_read(
+    const Handle& handle, std::size_t nb, std::uint64_t offset, Callback callback
+) {
+    const auto nb_dword = async::check_io_size(nb);
+
+    auto op = std::make_unique<Operation>(offset);
+    op->handle = handle.get();
+    op->reading = true;
+    op->buffer.resize(nb);
+    op->callback = std::move(callback);
+
+    track(op.get());
+    const auto ret = ::ReadFile(handle.get(), op->buffer.data(), nb_dword, NULL, op.get());
+    start(op.release(), ret);
+}
+
+void IoCompletionPort::async_write(
+    const Handle& handle, Buffer buffer, std::uint64_t offset, Callback callback
+) {
+    const auto nb_dword = async::check_io_size(buffer.size());
+
+    auto op = std::make_unique<Operation>(offset);
+    op->handle = handle.get();
+    op->buffer = std::move(buffer);
+    op->callback = std::move(callback);
+
+    track(op.get());
+    const auto ret = ::WriteFile(handle.get(), op->buffer.data(), nb_dword, NULL, op.get());
+    start(op.release(), ret);
+}
+
+void IoCompletionPort::post(Task task) {
+    auto op = std::make_unique<Operation>();
+    op->task = std::move(task);
+
+    track(op.get());
+    queue(op.release(), task_key);
+}
+
+void IoCompletionPort::start(Operation* op, BOOL ret) {
+    if (ret)
+        return;
+    const auto ec = GetLastError();
+    if (ec == ERROR_IO_PENDING)
+        return;
+
+    // No completion packet is queued if an operation fails immediately.
+    // Queue one manually, so that callbacks are always called the same way.
+    op->error = ec;
+    queue(op, io_key);
+}
+
+void IoCompletionPort::queue(Operation* op, ULONG_PTR key) {
+    if (!::PostQueuedCompletionStatus(get(), 0, key, op)) {
+        const auto ec = GetLastError();
+        untrack(op);
+        delete op;
+        --m_pending;
+        throw error::windows(ec, "PostQueuedCompletionStatus");
+    }
+}
+
+bool IoCompletionPort::run_once(DWORD timeout) {
+    DWORD nb = 0;
+    ULONG_PTR key = 0;
+    OVERLAPPED* overlapped = NULL;
+
+    const auto ret = ::GetQueuedCompletionStatus(get(), &nb, &key, &overlapped, timeout);
+
+    if (overlapped == NULL) {
+        if (ret)
+            // Only the quit packets have no OVERLAPPED.
+            return false;
+        const auto ec = GetLastError();
+        if (ec == WAIT_TIMEOUT)
+            return false;
+        throw error::windows(ec, "GetQueuedCompletionStatus");
+    }
+
+    const std::unique_ptr<Operation> op{static_cast<Operation*>(overlapped)};
+    const PendingGuard pending{m_pending};
+    const auto ec = ret ? op->error : GetLastError();
+
+    try {
+        if (key == task_key) {
+            op->task();
+            return true;
+        }
+
+        untrack(op.get());
+        record(*op, ec, nb);
+
+        Result result;
+        result.error = ec;
+        result.nb = nb;
+        result.buffer = std::move(op->buffer);
+        if (op->reading)
+            result.buffer.resize(nb);
+        op->callback(std::move(result));
+    } catch (...) {
+        save_error(std::current_exception());
+    }
+    return true;
+}
+
+void IoCompletionPort::record(const Operation& op, DWORD ec, DWORD nb) {
+#ifdef WINAPI_COMMON_IO_STATS
+    // Only the raw handles are at hand here.
+    const auto latency = IoStats::Clock::now() - op.start;
+    if (op.reading) {
+        if (ec == ERROR_SUCCESS || async::is_eof_error(ec))
+            IoStats::global().record_read(op.buffer.size(), nb, latency);
+    } else if (ec == ERROR_SUCCESS) {
+        IoStats::global().record_write(nb, latency);
+    }
+#else
+    static_cast<void>(op);
+    static_cast<void>(ec);
+    static_cast<void>(nb);
+#endif
+}
+
+void IoCompletionPort::run() {
+    try {
+        while (run_once(INFINITE)) {
+        }
+    } catch (...) {
+        save_error(std::current_exception());
+    }
+}
+
+void IoCompletionPort::stop() {
+    // It'd wait for itself to quit.
+    const auto self = std::this_thread::get_id();
+    for (const auto& worker : m_workers)
+        if (worker.get_id() == self)
+            throw std::runtime_error{"Completion port can't be stopped from its worker thread"};
+
+    for (std::size_t i = 0; i < m_workers.size(); ++i) {
+        if (!::PostQueuedCompletionStatus(get(), 0, quit_key, NULL)) {
+            throw error::windows(GetLastError(), "PostQueuedCompletionStatus");
+        }
+    }
+    for (auto& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+
+    // The operations in flight still reference their OVERLAPPED structures &
+    // buffers.
+    // Their callbacks may start new operations, so cancel those as well.
+    while (true) {
+        {
+            // Nothing can be started once the port is stopped, so nothing
+            // can sneak in after the last check.
+            std::lock_guard<std::mutex> lock{m_mutex};
+            if (m_pending.load() == 0) {
+                m_stopped = true;
+                break;
+            }
+        }
+        cancel_all();
+        run_once(INFINITE);
+    }
+
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock{m_mutex};
+        error = std::exchange(m_error, nullptr);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+void IoCompletionPort::track(Operation* op) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (m_stopped)
+        throw std::runtime_error{"Completion port has been stopped"};
+    // Tasks can't be cancelled.
+    if (!op->task)
+        m_in_flight.emplace(op);
+    ++m_pending;
+}
+
+void IoCompletionPort::untrack(Operation* op) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    m_in_flight.erase(op);
+}
+
+void IoCompletionPort::cancel_all() {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    // Cancel individual operations: even if a handle has been closed & its
+    // value reused, nothing else could be using the same OVERLAPPED.
+    // This fails for the operations that have already completed.
+    for (const auto op : m_in_flight)
+        ::CancelIoEx(op->handle, op);
+}
+
+void IoCompletionPort::save_error(std::exception_ptr error) {
+    std::lock_guard<std::mutex> lock{m_mutex};
+    if (!m_error)
+        m_error = error;
+}
+
+} // namespace winapi
@@ -0,0 +1,79 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include <winapi/io_stats.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace winapi {
+namespace {
+
+void increment(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) {
+    // Only the totals matter, not the ordering.
+    counter.fetch_add(n, std::memory_order_relaxed);
+}
+
+std::uint64_t load(const std::atomic<std::uint64_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+}
+
+} // namespace
+
+IoStats& IoStats::global() {
+    static IoStats instance;
+    return instance;
+}
+
+std::size_t IoStats::bucket(Clock::duration latency) {
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    if (us <= 0)
+        return 0;
+    const auto width = std::bit_width(static_cast<std::uint64_t>(us));
+    return std::min<std::size_t>(width, numof_buckets - 1);
+}
+
+void IoStats::record_read(std::size_t nb, std::size_t nb_read, Clock::duration latency) {
+    increment(m_reads);
+    increment(m_bytes_read, nb_read);
+    if (nb_read < nb)
+        increment(m_short_reads);
+    increment(m_read_latency[bucket(latency)]);
+}
+
+void IoStats::record_write(std::size_t nb, Clock::duration latency) {
+    increment(m_writes);
+    increment(m_bytes_written, nb);
+    increment(m_write_latency[bucket(latency)]);
+}
+
+IoStats::Snapshot IoStats::snapshot() const {
+    Snapshot result;
+    result.reads = load(m_reads);
+    result.bytes_read = load(m_bytes_read);
+    result.short_reads = load(m_short_reads);
+    result.writes = load(m_writes);
+    result.bytes_written = load(m_bytes_written);
+    for (std::size_t i = 0; i < numof_buckets; ++i) {
+        result.read_latency[i] = load(m_read_latency[i]);
+        result.write_latency[i] = load(m_write_latency[i]);
+    }
+    return result;
+}
+
+void IoStats::reset() {
+    for (auto* counter : {&m_reads, &m_bytes_read, &m_short_reads, &m_writes, &m_bytes_written})
+        counter->store(0, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < numof_buckets; ++i) {
+        m_read_latency[i].store(0, std::memory_order_relaxed);
+        m_write_latency[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+} // namespace winapi
@@ -0,0 +1,209 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+/**
+ * @file
+ * @brief Helpers for spreading work across multiple threads.
+ *
+ * Failures are handled the same way everywhere: the first exception, be it
+ * thrown by the work itself or by std::thread when a thread can't be
+ * started, makes the other threads quit early, and is rethrown once they're
+ * done.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace winapi::parallel {
+
+/** Default number of threads: one per CPU core. */
+inline std::size_t default_thread_count() {
+    const auto n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+/** @brief Runs a function on multiple threads & collects the first error. */
+class Workers {
+public:
+    Workers() = default;
+
+    /** @param on_fail Called once, on the first error, to make the threads quit early. */
+    explicit Workers(std::function<void()> on_fail) : m_on_fail{std::move(on_fail)} {}
+
+    Workers(const Workers&) = delete;
+    Workers& operator=(const Workers&) = delete;
+
+    /**
+     * Run a function on new helper threads, and another one on the calling
+     * thread, then wait for the helpers to finish.
+     * @param numof_helpers Number of helper threads.
+     * @param fn            Function to run on every helper thread.
+     * @param main          Function to run on the calling thread.
+     */
+    template <typename Fn, typename Main>
+    void run(std::size_t numof_helpers, const Fn& fn, const Main& main) {
+        std::vector<std::thread> helpers;
+        try {
+            helpers.reserve(numof_helpers);
+            for (std::size_t i = 0; i < numof_helpers; ++i) {
+                started();
+                try {
+                    helpers.emplace_back([this, &fn]() {
+                        call(fn);
+                        finished();
+                    });
+                } catch (...) {
+                    finished();
+                    throw;
+                }
+            }
+        } catch (...) {
+            fail(std::current_exception());
+        }
+
+        call(main);
+        for (auto& helper : helpers)
+            helper.join();
+
+        if (m_error)
+            std::rethrow_exception(m_error);
+    }
+
+    /**
+     * Run a function on multiple threads, the calling thread being one of
+     * them, and wait for them to finish.
+     */
+    template <typename Fn>
+    void run(std::size_t numof_threads, const Fn& fn) {
+        run(std::max<std::size_t>(numof_threads, 1) - 1, fn, fn);
+    }
+
+    /**
+     * Wait for the helper threads to finish.
+     * @return `true` if they have, `false` on timeout.
+     */
+    bool wait_for(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lck{m_mtx};
+        return m_cv.wait_for(lck, timeout, [this]() { return m_running == 0; });
+    }
+
+    /** Record an error & make the threads quit early. */
+    void fail(std::exception_ptr error) {
+        {
+            std::lock_guard<std::mutex> lck{m_mtx};
+            if (m_error)
+                return;
+            m_error = std::move(error);
+        }
+        if (m_on_fail)
+            m_on_fail();
+    }
+
+private:
+    template <typename Fn>
+    void call(const Fn& fn) {
+        try {
+            fn();
+        } catch (...) {
+            fail(std::current_exception());
+        }
+    }
+
+    void started() {
+        std::lock_guard<std::mutex> lck{m_mtx};
+        ++m_running;
+    }
+
+    void finished() {
+        {
+            std::lock_guard<std::mutex> lck{m_mtx};
+            --m_running;
+        }
+        m_cv.notify_all();
+    }
+
+    std::function<void()> m_on_fail;
+
+    std::mutex m_mtx;
+    std::condition_variable m_cv;
+    // Number of helper threads still running.
+    std::size_t m_running = 0;
+    std::exception_ptr m_error;
+};
+
+/** @brief Hands out the indices in [0, n) in blocks, to multiple threads. */
+class Loop {
+public:
+    explicit Loop(std::uint64_t n, std::uint64_t block_size = 1)
+        : m_n{n}, m_block_size{block_size} {}
+
+    std::uint64_t numof_blocks() const {
+        return (m_n + m_block_size - 1) / m_block_size;
+    }
+
+    /**
+     * Grab the next block of indices.
+     * @param begin Receives the first index of the block.
+     * @param end   Receives the index past the last one.
+     * @return `false` if there're no indices left.
+     */
+    bool next(std::uint64_t& begin, std::uint64_t& end) {
+        begin = m_next.fetch_add(m_block_size);
+        if (begin >= m_n)
+            return false;
+        end = begin + std::min(m_block_size, m_n - begin);
+        return true;
+    }
+
+    /** Make next() return `false` from now on. */
+    void stop() {
+        m_next = m_n;
+    }
+
+private:
+    const std::uint64_t m_n;
+    const std::uint64_t m_block_size;
+    std::atomic<std::uint64_t> m_next{0};
+};
+
+/**
+ * Call a function for every index in [0, n) using multiple threads, the
+ * calling thread being one of them.
+ * @param n             Number of indices.
+ * @param block_size    Number of consecutive indices a thread grabs at once.
+ * @param numof_threads Maximum number of threads.
+ * @param fn            Called with every index.
+ */
+template <typename Fn>
+void for_each(std::uint64_t n, std::uint64_t block_size, std::size_t numof_threads, const Fn& fn) {
+    Loop loop{n, block_size};
+    Workers workers{[&loop]() { loop.stop(); }};
+
+    const auto work = [&loop, &fn]() {
+        std::uint64_t begin = 0;
+        std::uint64_t end = 0;
+        while (loop.next(begin, end))
+            for (auto i = begin; i < end; ++i)
+                fn(i);
+    };
+
+    const auto max_threads = std::max<std::uint64_t>(1, loop.numof_blocks());
+    const auto threads = std::min<std::uint64_t>(numof_threads, max_threads);
+    workers.run(static_cast<std::size_t>(threads), work);
+}
+
+} // namespace winapi::parallel
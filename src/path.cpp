@@ -3,9 +3,10 @@
 // For details, see https://github.com/egor-tensin/winapi-common.
 // Distributed under the MIT License.
 
+#include "unicode.hpp"
+
 #include <winapi/error.hpp>
 #include <winapi/path.hpp>
-#include <winapi/utf8.hpp>
 
 #include <windows.h>
 
@@ -13,12 +14,14 @@
 #include <limits>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace winapi {
 namespace {
 
-std::wstring do_canonicalize(std::wstring_view path) {
+// The path must be null-terminated.
+std::wstring do_canonicalize(const std::wstring& path) {
     static constexpr std::size_t init_buffer_size = MAX_PATH;
     static_assert(init_buffer_size > 0, "init_buffer_size must be positive");
 
@@ -29,7 +32,7 @@ std::wstring do_canonicalize(std::wstring_view path) {
         if (buffer.size() > std::numeric_limits<DWORD>::max())
             throw std::range_error{"Path buffer is too large"};
         const auto nch =
-            ::GetFullPathNameW(path.data(), static_cast<DWORD>(buffer.size()), buffer.data(), NULL);
+            ::GetFullPathNameW(path.c_str(), static_cast<DWORD>(buffer.size()), buffer.data(), NULL);
 
         if (nch == 0) {
             throw error::windows(GetLastError(), "GetFullPathNameW");
@@ -47,10 +50,22 @@ std::wstring do_canonicalize(std::wstring_view path) {
 
 } // namespace
 
-CanonicalPath::CanonicalPath(std::string_view path) : m_path{canonicalize(path)} {}
+CanonicalPath::CanonicalPath(std::string_view path)
+    : m_wide_path{do_canonicalize(unicode::widen(path))} {
+    m_path = unicode::narrow(m_wide_path);
+}
+
+CanonicalPath::CanonicalPath(std::wstring_view path)
+    : m_wide_path{do_canonicalize(std::wstring{path})} {
+    m_path = unicode::narrow(m_wide_path);
+}
 
 std::string CanonicalPath::canonicalize(std::string_view path) {
-    return narrow(do_canonicalize(widen(path)));
+    return unicode::narrow(do_canonicalize(unicode::widen(path)));
+}
+
+std::wstring CanonicalPath::canonicalize(std::wstring_view path) {
+    return do_canonicalize(std::wstring{path});
 }
 
 } // namespace winapi
@@ -9,24 +9,46 @@
 
 #include <windows.h>
 
+#include <atomic>
+#include <cstddef>
 #include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include <utility>
 
 namespace winapi {
 namespace {
 
-void create_pipe(Handle& read_end, Handle& write_end) {
-    HANDLE read_end_impl = INVALID_HANDLE_VALUE;
-    HANDLE write_end_impl = INVALID_HANDLE_VALUE;
-
+SECURITY_ATTRIBUTES inheritable_attributes() {
     SECURITY_ATTRIBUTES attributes;
     std::memset(&attributes, 0, sizeof(attributes));
     attributes.nLength = sizeof(attributes);
     attributes.bInheritHandle = TRUE;
+    return attributes;
+}
+
+DWORD check_buffer_size(std::size_t buffer_size) {
+    if (buffer_size > std::numeric_limits<DWORD>::max())
+        throw std::range_error{"Pipe buffer is too large"};
+    return static_cast<DWORD>(buffer_size);
+}
+
+std::wstring unique_pipe_name() {
+    static std::atomic<unsigned long long> counter{0};
+    return LR"(\\.\pipe\winapi-common.)" + std::to_wstring(::GetCurrentProcessId()) + L'.' +
+           std::to_wstring(++counter);
+}
+
+void create_pipe(Handle& read_end, Handle& write_end, std::size_t buffer_size) {
+    HANDLE read_end_impl = INVALID_HANDLE_VALUE;
+    HANDLE write_end_impl = INVALID_HANDLE_VALUE;
 
-    static constexpr DWORD buffer_size = 16 * 1024;
+    auto attributes = inheritable_attributes();
 
-    const auto ret = ::CreatePipe(&read_end_impl, &write_end_impl, &attributes, buffer_size);
+    const auto ret = ::CreatePipe(
+        &read_end_impl, &write_end_impl, &attributes, check_buffer_size(buffer_size)
+    );
 
     if (!ret) {
         throw error::windows(GetLastError(), "CreatePipe");
@@ -38,8 +60,41 @@ void create_pipe(Handle& read_end, Handle& write_end) {
 
 } // namespace
 
-Pipe::Pipe() {
-    create_pipe(m_read_end, m_write_end);
+Pipe::Pipe(std::size_t buffer_size) {
+    create_pipe(m_read_end, m_write_end, buffer_size);
+}
+
+Pipe Pipe::overlapped(std::size_t buffer_size) {
+    const auto name = unique_pipe_name();
+    const auto nb = check_buffer_size(buffer_size);
+    auto attributes = inheritable_attributes();
+
+    const auto read_end = ::CreateNamedPipeW(
+        name.c_str(),
+        PIPE_ACCESS_INBOUND | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+        1,
+        nb,
+        nb,
+        0,
+        &attributes
+    );
+
+    if (read_end == INVALID_HANDLE_VALUE) {
+        throw error::windows(GetLastError(), "CreateNamedPipeW");
+    }
+
+    Handle read_end_handle{read_end};
+
+    const auto write_end = ::CreateFileW(
+        name.c_str(), GENERIC_WRITE, 0, &attributes, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL
+    );
+
+    if (write_end == INVALID_HANDLE_VALUE) {
+        throw error::windows(GetLastError(), "CreateFileW");
+    }
+
+    return {std::move(read_end_handle), Handle{write_end}};
 }
 
 } // namespace winapi
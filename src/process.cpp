@@ -3,13 +3,16 @@
 // For details, see https://github.com/egor-tensin/winapi-common.
 // Distributed under the MIT License.
 
+#include "unicode.hpp"
+
 #include <winapi/cmd_line.hpp>
+#include <winapi/coro.hpp>
 #include <winapi/error.hpp>
 #include <winapi/handle.hpp>
+#include <winapi/pipe.hpp>
 #include <winapi/process.hpp>
 #include <winapi/process_io.hpp>
 #include <winapi/resource.hpp>
-#include <winapi/utf8.hpp>
 
 // clang-format off
 #include <windows.h>
@@ -22,23 +25,13 @@
 #include <limits>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 namespace winapi {
 namespace {
 
-using EscapedCommandLine = std::vector<wchar_t>;
-
-EscapedCommandLine escape_command_line(const CommandLine& cmd_line) {
-    const auto unicode_cmd_line = widen(cmd_line.to_string());
-    EscapedCommandLine buffer;
-    buffer.reserve(unicode_cmd_line.size() + 1);
-    buffer.assign(unicode_cmd_line.cbegin(), unicode_cmd_line.cend());
-    buffer.emplace_back(L'\0');
-    return buffer;
-}
-
 Handle create_process(ProcessParameters& params) {
     /*
      * When creating a new console process, the options are:
@@ -90,7 +83,8 @@ Handle create_process(ProcessParameters& params) {
     std::memset(&child_info, 0, sizeof(child_info));
 
     {
-        auto cmd_line = escape_command_line(params.cmd_line);
+        // CreateProcessW requires a writable, null-terminated string.
+        auto cmd_line = params.cmd_line.to_wstring();
 
         const auto ret = ::CreateProcessW(
             NULL,
@@ -121,9 +115,9 @@ Handle create_process(ProcessParameters& params) {
 }
 
 Handle shell_execute(const ShellParameters& params) {
-    const auto lpVerb = params.verb ? widen(*params.verb) : L"open";
-    const auto lpFile = widen(params.cmd_line.get_argv0());
-    const auto lpParameters = widen(params.cmd_line.args_to_string());
+    const auto lpVerb = params.verb ? unicode::widen(*params.verb) : L"open";
+    const auto& lpFile = params.cmd_line.get_wargv0();
+    const auto lpParameters = params.cmd_line.args_to_wstring();
 
     static constexpr uint32_t default_fMask = SEE_MASK_NOCLOSEPROCESS | SEE_MASK_FLAG_NO_UI;
 
@@ -214,7 +208,7 @@ std::string get_current_exe_path(PathBuffer& buffer) {
         return get_current_exe_path(buffer);
     }
 
-    return narrow(buffer.get_data());
+    return unicode::narrow(buffer.get_data());
 }
 
 std::string get_current_exe_path() {
@@ -228,7 +222,7 @@ std::string get_exe_path(const Handle& process, PathBuffer& buffer) {
     const auto ec = ::QueryFullProcessImageNameW(process.get(), 0, buffer.get_data(), &size);
 
     if (ec != 0) {
-        return narrow(buffer.get_data());
+        return unicode::narrow(buffer.get_data());
     }
 
     if (GetLastError() == ERROR_INSUFFICIENT_BUFFER) {
@@ -261,6 +255,18 @@ Process Process::create(const CommandLine& cmd_line, process::IO io) {
     return create(std::move(params));
 }
 
+int Process::read_each_stdout(
+    const CommandLine& cmd_line, const Handle::ChunkCallback& on_stdout
+) {
+    Pipe stdout_pipe;
+    process::IO io;
+    io.std_out = process::Stdout{stdout_pipe};
+    const auto process = create(cmd_line, std::move(io));
+    stdout_pipe.read_end().read_each(on_stdout);
+    process.wait();
+    return process.get_exit_code();
+}
+
 Process Process::shell(const ShellParameters& params) {
     return Process{shell_execute(params)};
 }
@@ -331,6 +337,10 @@ void Process::shut_down(int ec) const {
     wait();
 }
 
+coro::ProcessExit Process::exited() const {
+    return coro::ProcessExit{*this};
+}
+
 int Process::get_exit_code() const {
     DWORD ec = 0;
 
@@ -372,7 +382,7 @@ std::string Process::get_resource_string(uint32_t id) {
         throw error::windows(GetLastError(), "LoadStringW");
     }
 
-    return narrow(s, nch * sizeof(wchar_t));
+    return unicode::narrow(std::wstring_view{s, static_cast<std::size_t>(nch)});
 }
 
 Resource Process::get_resource(uint32_t id) {
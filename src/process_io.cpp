@@ -21,14 +21,20 @@ Stderr::Stderr() : Stream{Handle::std_err()} {}
 
 Stdin::Stdin(std::string_view path) : Stream{File::open_r(path)} {}
 
+Stdin::Stdin(std::wstring_view path) : Stream{File::open_r(path)} {}
+
 Stdin::Stdin(const CanonicalPath& path) : Stream{File::open_r(path)} {}
 
 Stdout::Stdout(std::string_view path) : Stream{File::open_w(path)} {}
 
+Stdout::Stdout(std::wstring_view path) : Stream{File::open_w(path)} {}
+
 Stdout::Stdout(const CanonicalPath& path) : Stream{File::open_w(path)} {}
 
 Stderr::Stderr(std::string_view path) : Stream{File::open_w(path)} {}
 
+Stderr::Stderr(std::wstring_view path) : Stream{File::open_w(path)} {}
+
 Stderr::Stderr(const CanonicalPath& path) : Stream{File::open_w(path)} {}
 
 Stdin::Stdin(Pipe& pipe) : Stream{std::move(pipe.read_end())} {
@@ -3,24 +3,37 @@
 // For details, see https://github.com/egor-tensin/winapi-common.
 // Distributed under the MIT License.
 
+#include "unicode.hpp"
+
 #include <winapi/error.hpp>
 #include <winapi/handle.hpp>
 #include <winapi/shmem.hpp>
-#include <winapi/utf8.hpp>
 #include <winapi/utils.hpp>
 
 #include <windows.h>
 
 #include <cstddef>
 #include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
 #include <string_view>
 #include <utility>
 
 namespace winapi {
 namespace {
 
-void* do_map(const Handle& mapping, std::size_t nb = 0) {
-    const auto addr = ::MapViewOfFile(static_cast<HANDLE>(mapping), FILE_MAP_ALL_ACCESS, 0, 0, nb);
+void* do_map(
+    const Handle& mapping,
+    std::size_t nb = 0,
+    DWORD access = FILE_MAP_ALL_ACCESS,
+    std::uint64_t offset = 0
+) {
+    const auto offset_low = static_cast<DWORD>(offset);
+    const auto offset_high = static_cast<DWORD>(offset >> 32);
+
+    const auto addr =
+        ::MapViewOfFile(static_cast<HANDLE>(mapping), access, offset_high, offset_low, nb);
 
     if (addr == NULL) {
         throw error::windows(GetLastError(), "MapViewOfFile");
@@ -29,15 +42,37 @@ void* do_map(const Handle& mapping, std::size_t nb = 0) {
     return addr;
 }
 
+std::uint64_t allocation_granularity() {
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+}
+
 } // namespace
 
-void SharedMemory::Unmap::operator()(void* ptr) const {
+void UnmapView::operator()(void* ptr) const {
     const auto ret = ::UnmapViewOfFile(ptr);
     assert(ret);
     WINAPI_UNUSED_PARAMETER(ret);
 };
 
 SharedMemory SharedMemory::create(std::string_view name, std::size_t nb) {
+    return create_mapping(unicode::widen(name), nb);
+}
+
+SharedMemory SharedMemory::create(std::wstring_view name, std::size_t nb) {
+    return create_mapping(std::wstring{name}, nb);
+}
+
+SharedMemory SharedMemory::open(std::string_view name) {
+    return open_mapping(unicode::widen(name));
+}
+
+SharedMemory SharedMemory::open(std::wstring_view name) {
+    return open_mapping(std::wstring{name});
+}
+
+SharedMemory SharedMemory::create_mapping(const std::wstring& name, std::size_t nb) {
     const auto nb64 = static_cast<std::uint64_t>(nb);
     static_assert(sizeof(nb64) == 2 * sizeof(DWORD), "sizeof(DWORD) != 32");
 
@@ -45,7 +80,7 @@ SharedMemory SharedMemory::create(std::string_view name, std::size_t nb) {
     const auto nb_high = static_cast<DWORD>(nb64 >> 32);
 
     const auto mapping_impl = ::CreateFileMappingW(
-        INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, nb_high, nb_low, widen(name).c_str()
+        INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, nb_high, nb_low, name.c_str()
     );
 
     if (mapping_impl == NULL) {
@@ -57,8 +92,8 @@ SharedMemory SharedMemory::create(std::string_view name, std::size_t nb) {
     return {std::move(mapping), addr};
 }
 
-SharedMemory SharedMemory::open(std::string_view name) {
-    const auto mapping_impl = ::OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, widen(name).c_str());
+SharedMemory SharedMemory::open_mapping(const std::wstring& name) {
+    const auto mapping_impl = ::OpenFileMappingW(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
 
     if (mapping_impl == NULL) {
         throw error::windows(GetLastError(), "OpenFileMappingW");
@@ -69,4 +104,47 @@ SharedMemory SharedMemory::open(std::string_view name) {
     return {std::move(mapping), addr};
 }
 
+MappedView MappedView::map_r(const Handle& file, std::uint64_t offset, std::size_t nb) {
+    // Mapping an empty file fails.
+    if (nb == 0)
+        return {};
+
+    // Map the whole file, only the view is limited to the range.
+    const auto mapping_impl = ::CreateFileMappingW(
+        static_cast<HANDLE>(file), NULL, PAGE_READONLY, 0, 0, NULL
+    );
+
+    if (mapping_impl == NULL) {
+        throw error::windows(GetLastError(), "CreateFileMappingW");
+    }
+
+    // The view stays valid after the mapping handle is closed.
+    const Handle mapping{mapping_impl};
+
+    // Views must start at a multiple of the allocation granularity.
+    static const auto granularity = allocation_granularity();
+    const auto delta = static_cast<std::size_t>(offset % granularity);
+
+    if (nb > std::numeric_limits<std::size_t>::max() - delta)
+        throw std::range_error{"Mapped view is too large"};
+
+    const auto addr = do_map(mapping, delta + nb, FILE_MAP_READ, offset - delta);
+    return {addr, delta, nb};
+}
+
+void MappedView::prefetch(std::size_t offset, std::size_t nb) const {
+    if (offset > size() || nb > size() - offset)
+        throw std::range_error{"Prefetch range is outside of the mapped view"};
+    if (nb == 0)
+        return;
+
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<std::byte*>(data() + offset);
+    range.NumberOfBytes = nb;
+
+    if (!::PrefetchVirtualMemory(::GetCurrentProcess(), 1, &range, 0)) {
+        throw error::windows(GetLastError(), "PrefetchVirtualMemory");
+    }
+}
+
 } // namespace winapi
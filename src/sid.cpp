@@ -3,10 +3,11 @@
 // For details, see https://github.com/egor-tensin/winapi-common.
 // Distributed under the MIT License.
 
+#include "unicode.hpp"
+
 #include <winapi/buffer.hpp>
 #include <winapi/error.hpp>
 #include <winapi/sid.hpp>
-#include <winapi/utf8.hpp>
 #include <winapi/utils.hpp>
 
 // clang-format off
@@ -42,7 +43,7 @@ std::string Sid::to_string() const {
     if (!::ConvertSidToStringSidW(const_cast<Impl*>(&get_impl()), &s))
         throw error::windows(GetLastError(), "ConvertSidToStringSidW");
 
-    return narrow(std::unique_ptr<wchar_t, LocalDelete>{s}.get());
+    return unicode::narrow(std::unique_ptr<wchar_t, LocalDelete>{s}.get());
 }
 
 } // namespace winapi
@@ -0,0 +1,272 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "unicode.hpp"
+
+#include <winapi/utf8.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define WINAPI_UNICODE_X86
+#endif
+
+#ifdef WINAPI_UNICODE_X86
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#define WINAPI_TARGET(x)
+#else
+#define WINAPI_TARGET(x) __attribute__((target(x)))
+#endif
+
+namespace winapi::unicode {
+namespace {
+
+static_assert(sizeof(wchar_t) == sizeof(std::uint16_t), "wchar_t must be a UTF-16 code unit");
+
+std::size_t widen_ascii_scalar(const char* src, std::size_t nch, std::uint16_t* dest) {
+    std::size_t i = 0;
+    for (; i < nch; ++i) {
+        const auto c = static_cast<unsigned char>(src[i]);
+        if (c >= 0x80)
+            break;
+        dest[i] = c;
+    }
+    return i;
+}
+
+std::size_t narrow_ascii_scalar(const std::uint16_t* src, std::size_t nch, char* dest) {
+    std::size_t i = 0;
+    for (; i < nch; ++i) {
+        const auto c = src[i];
+        if (c >= 0x80)
+            break;
+        dest[i] = static_cast<char>(c);
+    }
+    return i;
+}
+
+#ifdef WINAPI_UNICODE_X86
+
+WINAPI_TARGET("sse2")
+std::size_t widen_ascii_sse2(const char* src, std::size_t nch, std::uint16_t* dest) {
+    const auto zero = _mm_setzero_si128();
+    std::size_t i = 0;
+
+    for (; i + 16 <= nch; i += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        if (_mm_movemask_epi8(v) != 0)
+            break;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+
+    return i + widen_ascii_scalar(src + i, nch - i, dest + i);
+}
+
+WINAPI_TARGET("sse2")
+std::size_t narrow_ascii_sse2(const std::uint16_t* src, std::size_t nch, char* dest) {
+    const auto zero = _mm_setzero_si128();
+    const auto non_ascii = _mm_set1_epi16(static_cast<short>(0xff80));
+    std::size_t i = 0;
+
+    for (; i + 16 <= nch; i += 16) {
+        const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+        const auto high_bits = _mm_and_si128(_mm_or_si128(a, b), non_ascii);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, zero)) != 0xffff)
+            break;
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + i), _mm_packus_epi16(a, b));
+    }
+
+    return i + narrow_ascii_scalar(src + i, nch - i, dest + i);
+}
+
+WINAPI_TARGET("avx2")
+std::size_t widen_ascii_avx2(const char* src, std::size_t nch, std::uint16_t* dest) {
+    std::size_t i = 0;
+
+    for (; i + 32 <= nch; i += 32) {
+        const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        if (_mm256_movemask_epi8(v) != 0)
+            break;
+        const auto lo = _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v));
+        const auto hi = _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i + 16), hi);
+    }
+
+    return i + widen_ascii_sse2(src + i, nch - i, dest + i);
+}
+
+WINAPI_TARGET("avx2")
+std::size_t narrow_ascii_avx2(const std::uint16_t* src, std::size_t nch, char* dest) {
+    const auto non_ascii = _mm256_set1_epi16(static_cast<short>(0xff80));
+    std::size_t i = 0;
+
+    for (; i + 32 <= nch; i += 32) {
+        const auto a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const auto b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16));
+        if (!_mm256_testz_si256(_mm256_or_si256(a, b), non_ascii))
+            break;
+        // packus works on 128-bit lanes, so the result needs reordering.
+        const auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + i), packed);
+    }
+
+    return i + narrow_ascii_sse2(src + i, nch - i, dest + i);
+}
+
+#ifdef _MSC_VER
+
+bool cpu_has_sse2() {
+    int regs[4];
+    __cpuid(regs, 1);
+    return (regs[3] & (1 << 26)) != 0;
+}
+
+bool cpu_has_avx2() {
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+        return false;
+    __cpuid(regs, 1);
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    // The OS must save the YMM registers on context switches.
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+}
+
+#else
+
+bool cpu_has_sse2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+}
+
+bool cpu_has_avx2() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+#endif
+
+#endif // WINAPI_UNICODE_X86
+
+struct Kernels {
+    std::size_t (*widen_ascii)(const char*, std::size_t, std::uint16_t*);
+    std::size_t (*narrow_ascii)(const std::uint16_t*, std::size_t, char*);
+};
+
+Kernels get_kernels(Kernel kernel) {
+    switch (kernel) {
+#ifdef WINAPI_UNICODE_X86
+        case Kernel::AVX2:
+            return {&widen_ascii_avx2, &narrow_ascii_avx2};
+        case Kernel::SSE2:
+            return {&widen_ascii_sse2, &narrow_ascii_sse2};
+#endif
+        case Kernel::Scalar:
+            return {&widen_ascii_scalar, &narrow_ascii_scalar};
+        default:
+            throw std::runtime_error{"Unsupported ASCII conversion kernel"};
+    }
+}
+
+Kernels select_kernels() {
+    for (const auto kernel : {Kernel::AVX2, Kernel::SSE2})
+        if (is_supported(kernel))
+            return get_kernels(kernel);
+    return get_kernels(Kernel::Scalar);
+}
+
+Kernels checked_kernels(Kernel kernel) {
+    if (!is_supported(kernel))
+        throw std::runtime_error{"Unsupported ASCII conversion kernel"};
+    return get_kernels(kernel);
+}
+
+const Kernels& kernels() {
+    static const Kernels instance = select_kernels();
+    return instance;
+}
+
+} // namespace
+
+bool is_supported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar:
+            return true;
+#ifdef WINAPI_UNICODE_X86
+        case Kernel::SSE2:
+            return cpu_has_sse2();
+        case Kernel::AVX2:
+            return cpu_has_avx2();
+#endif
+        default:
+            return false;
+    }
+}
+
+std::size_t widen_ascii(Kernel kernel, const char* src, std::size_t nch, std::uint16_t* dest) {
+    return checked_kernels(kernel).widen_ascii(src, nch, dest);
+}
+
+std::size_t narrow_ascii(Kernel kernel, const std::uint16_t* src, std::size_t nch, char* dest) {
+    return checked_kernels(kernel).narrow_ascii(src, nch, dest);
+}
+
+std::size_t widen_ascii(const char* src, std::size_t nch, std::uint16_t* dest) {
+    return kernels().widen_ascii(src, nch, dest);
+}
+
+std::size_t narrow_ascii(const std::uint16_t* src, std::size_t nch, char* dest) {
+    return kernels().narrow_ascii(src, nch, dest);
+}
+
+std::wstring widen(std::string_view src) {
+    std::wstring dest;
+    dest.resize(src.size());
+
+    const auto nch =
+        widen_ascii(src.data(), src.size(), reinterpret_cast<std::uint16_t*>(dest.data()));
+    if (nch == src.size())
+        return dest;
+
+    // The ASCII prefix ends on a character boundary, so the rest can be
+    // converted separately.
+    dest.resize(nch);
+    dest += winapi::widen(src.substr(nch));
+    return dest;
+}
+
+std::string narrow(std::wstring_view src) {
+    std::string dest;
+    dest.resize(src.size());
+
+    const auto nch =
+        narrow_ascii(reinterpret_cast<const std::uint16_t*>(src.data()), src.size(), dest.data());
+    if (nch == src.size())
+        return dest;
+
+    dest.resize(nch);
+    dest += winapi::narrow(src.substr(nch));
+    return dest;
+}
+
+} // namespace winapi::unicode
@@ -0,0 +1,71 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+/**
+ * @file
+ * @brief UTF-8 <-> UTF-16 conversion with a vectorized ASCII fast path.
+ *
+ * Paths, command lines & error messages are almost always ASCII.
+ * The longest ASCII prefix of a string is converted using SSE2/AVX2 (picked
+ * at runtime); only the remainder, if any, goes through the generic
+ * conversion routines from winapi-utf8.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace winapi::unicode {
+
+/**
+ * Convert the leading ASCII characters of a UTF-8 string to UTF-16.
+ * @param src  UTF-8 string.
+ * @param nch  Length of `src`.
+ * @param dest Receives at least as many UTF-16 code units as returned.
+ * @return Number of ASCII characters converted.
+ */
+std::size_t widen_ascii(const char* src, std::size_t nch, std::uint16_t* dest);
+
+/**
+ * Convert the leading ASCII characters of a UTF-16 string to UTF-8.
+ * @param src  UTF-16 string.
+ * @param nch  Length of `src`.
+ * @param dest Receives at least as many bytes as returned.
+ * @return Number of ASCII characters converted.
+ */
+std::size_t narrow_ascii(const std::uint16_t* src, std::size_t nch, char* dest);
+
+/** @brief Implementations of the ASCII conversion routines. */
+enum class Kernel {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+/** Check if the CPU supports a kernel. */
+bool is_supported(Kernel);
+
+/**
+ * Same as widen_ascii(), but using a specific kernel, for testing.
+ * @throws std::runtime_error If the kernel isn't supported.
+ */
+std::size_t widen_ascii(Kernel, const char* src, std::size_t nch, std::uint16_t* dest);
+
+/**
+ * Same as narrow_ascii(), but using a specific kernel, for testing.
+ * @throws std::runtime_error If the kernel isn't supported.
+ */
+std::size_t narrow_ascii(Kernel, const std::uint16_t* src, std::size_t nch, char* dest);
+
+/** Convert a UTF-8 string to UTF-16. */
+std::wstring widen(std::string_view);
+
+/** Convert a UTF-16 string to UTF-8. */
+std::string narrow(std::wstring_view);
+
+} // namespace winapi::unicode
@@ -0,0 +1,329 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "async.hpp"
+
+#include <winapi/error.hpp>
+#include <winapi/handle.hpp>
+#include <winapi/wait_set.hpp>
+
+#include <windows.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace winapi {
+namespace {
+
+// Each group needs a slot for an extra event.
+constexpr std::size_t group_size = MAXIMUM_WAIT_OBJECTS - 1;
+constexpr std::size_t no_index = std::numeric_limits<std::size_t>::max();
+
+std::optional<std::size_t> wait_for_multiple(
+    const std::vector<HANDLE>& handles, bool all, DWORD timeout
+) {
+    const auto n = static_cast<DWORD>(handles.size());
+    const auto ret = ::WaitForMultipleObjects(n, handles.data(), all, timeout);
+
+    if (ret >= WAIT_OBJECT_0 && ret < WAIT_OBJECT_0 + n)
+        return ret - WAIT_OBJECT_0;
+    // An abandoned mutex is still signalled.
+    if (ret >= WAIT_ABANDONED_0 && ret < WAIT_ABANDONED_0 + n)
+        return ret - WAIT_ABANDONED_0;
+    if (ret == WAIT_TIMEOUT)
+        return {};
+    if (ret == WAIT_FAILED)
+        throw error::windows(GetLastError(), "WaitForMultipleObjects");
+    // Shouldn't happen.
+    throw error::custom(ret, "WaitForMultipleObjects");
+}
+
+std::vector<HANDLE> make_group(
+    const std::vector<HANDLE>& handles, std::size_t begin, std::size_t n, HANDLE extra
+) {
+    const auto end = std::min(begin + n, handles.size());
+    std::vector<HANDLE> group{handles.begin() + begin, handles.begin() + end};
+    if (extra != NULL)
+        group.emplace_back(extra);
+    return group;
+}
+
+Handle create_auto_reset_event() {
+    const auto event = ::CreateEventW(NULL, FALSE, FALSE, NULL);
+    if (event == NULL)
+        throw error::windows(GetLastError(), "CreateEventW");
+    return Handle{event};
+}
+
+// Undo a wait for an object: release a mutex or a semaphore, or set an event.
+// The calls that don't apply to the object simply fail.
+void give_back(HANDLE handle) {
+    if (::ReleaseMutex(handle))
+        return;
+    if (::ReleaseSemaphore(handle, 1, NULL))
+        return;
+    // Fails for processes & threads, which stay signalled anyway.
+    ::SetEvent(handle);
+}
+
+bool try_acquire(HANDLE handle) {
+    return wait_for_multiple({handle}, false, 0).has_value();
+}
+
+} // namespace
+
+class WaitSet::Helpers {
+public:
+    explicit Helpers(const std::vector<HANDLE>& handles)
+        : m_cancel{async::create_event()},
+          m_found{async::create_event()},
+          // The calling thread waits for the first group itself.
+          m_first_group{make_group(handles, 0, group_size, m_found.get())} {
+        try {
+            for (std::size_t begin = group_size; begin < handles.size(); begin += group_size) {
+                auto helper = std::make_unique<Helper>();
+                helper->group = make_group(handles, begin, group_size, m_cancel.get());
+                helper->begin = begin;
+                helper->start = create_auto_reset_event();
+                helper->done = create_auto_reset_event();
+                m_helpers.emplace_back(std::move(helper));
+
+                auto& added = *m_helpers.back();
+                added.thread = std::thread{&Helpers::run, this, std::ref(added)};
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    ~Helpers() {
+        stop();
+    }
+
+    Helpers(const Helpers&) = delete;
+    Helpers& operator=(const Helpers&) = delete;
+
+    std::optional<std::size_t> wait_any(const std::vector<HANDLE>& handles, DWORD timeout) {
+        using clock = std::chrono::steady_clock;
+        const auto deadline = clock::now() + std::chrono::milliseconds{timeout};
+
+        while (true) {
+            DWORD remaining = INFINITE;
+            if (timeout != INFINITE) {
+                const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    deadline - clock::now()
+                );
+                remaining = async::to_timeout(left);
+            }
+
+            bool acquired = false;
+            const auto index = wait_round(remaining, acquired);
+            if (!index || acquired)
+                return index;
+            // A helper saw it signalled & gave it back; it might've been
+            // taken by somebody else since.
+            if (try_acquire(handles[*index]))
+                return index;
+            if (timeout != INFINITE && clock::now() >= deadline)
+                return {};
+        }
+    }
+
+private:
+    struct Helper {
+        std::vector<HANDLE> group;
+        std::size_t begin = 0;
+        // Both are auto-reset.
+        Handle start;
+        Handle done;
+        std::thread thread;
+    };
+
+    // Returns the index of a handle that's either been acquired by the
+    // calling thread, or seen signalled by one of the helpers.
+    std::optional<std::size_t> wait_round(DWORD timeout, bool& acquired) {
+        ::ResetEvent(m_cancel.get());
+        ::ResetEvent(m_found.get());
+        m_result = no_index;
+        m_error = nullptr;
+        for (const auto& helper : m_helpers)
+            ::SetEvent(helper->start.get());
+
+        std::optional<std::size_t> index;
+        std::exception_ptr error;
+        try {
+            index = wait_for_multiple(m_first_group, false, timeout);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        ::SetEvent(m_cancel.get());
+        for (const auto& helper : m_helpers)
+            ::WaitForSingleObject(helper->done.get(), INFINITE);
+
+        if (error)
+            std::rethrow_exception(error);
+        if (index && *index < group_size) {
+            acquired = true;
+            return index;
+        }
+        if (m_error)
+            std::rethrow_exception(m_error);
+        const auto result = m_result.load();
+        if (result == no_index)
+            return {};
+        return result;
+    }
+
+    void found(std::size_t index) {
+        std::size_t expected = no_index;
+        if (m_result.compare_exchange_strong(expected, index))
+            ::SetEvent(m_found.get());
+    }
+
+    void run(Helper& helper) {
+        while (true) {
+            ::WaitForSingleObject(helper.start.get(), INFINITE);
+            if (m_exit)
+                return;
+
+            try {
+                const auto index = wait_for_multiple(helper.group, false, INFINITE);
+                if (*index != helper.group.size() - 1) {
+                    // Let the calling thread acquire it instead.
+                    give_back(helper.group[*index]);
+                    found(helper.begin + *index);
+                }
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> lck{m_mtx};
+                    if (!m_error)
+                        m_error = std::current_exception();
+                }
+                ::SetEvent(m_found.get());
+            }
+
+            ::SetEvent(helper.done.get());
+        }
+    }
+
+    void stop() {
+        m_exit = true;
+        for (const auto& helper : m_helpers) {
+            if (!helper->thread.joinable())
+                continue;
+            ::SetEvent(helper->start.get());
+            helper->thread.join();
+        }
+        m_helpers.clear();
+    }
+
+    Handle m_cancel;
+    Handle m_found;
+    std::vector<HANDLE> m_first_group;
+    std::atomic<bool> m_exit{false};
+    std::atomic<std::size_t> m_result{no_index};
+    std::mutex m_mtx;
+    std::exception_ptr m_error;
+    std::vector<std::unique_ptr<Helper>> m_helpers;
+};
+
+WaitSet::WaitSet() = default;
+
+WaitSet::~WaitSet() = default;
+
+WaitSet::WaitSet(const WaitSet& other) : m_handles{other.m_handles} {}
+
+WaitSet& WaitSet::operator=(const WaitSet& other) {
+    if (this != &other) {
+        stop_helpers();
+        m_handles = other.m_handles;
+    }
+    return *this;
+}
+
+WaitSet::WaitSet(WaitSet&& other) noexcept = default;
+
+WaitSet& WaitSet::operator=(WaitSet&& other) noexcept = default;
+
+void WaitSet::stop_helpers() {
+    m_helpers.reset();
+}
+
+void WaitSet::remove(std::size_t index) {
+    if (index >= m_handles.size())
+        throw std::range_error{"Invalid wait set index"};
+    stop_helpers();
+    m_handles.erase(m_handles.begin() + index);
+}
+
+std::size_t WaitSet::wait_any() const {
+    return *wait_any(INFINITE);
+}
+
+std::optional<std::size_t> WaitSet::wait_any(std::chrono::milliseconds timeout) const {
+    return wait_any(async::to_timeout(timeout));
+}
+
+std::optional<std::size_t> WaitSet::wait_any(DWORD timeout) const {
+    if (m_handles.empty())
+        throw std::range_error{"Wait set is empty"};
+
+    if (m_handles.size() <= MAXIMUM_WAIT_OBJECTS)
+        return wait_for_multiple(m_handles, false, timeout);
+
+    if (!m_helpers)
+        m_helpers = std::make_unique<Helpers>(m_handles);
+    return m_helpers->wait_any(m_handles, timeout);
+}
+
+void WaitSet::wait_all() const {
+    wait_all(INFINITE);
+}
+
+bool WaitSet::wait_all(std::chrono::milliseconds timeout) const {
+    return wait_all(async::to_timeout(timeout));
+}
+
+bool WaitSet::wait_all(DWORD timeout) const {
+    if (m_handles.empty())
+        return true;
+
+    if (m_handles.size() <= MAXIMUM_WAIT_OBJECTS)
+        return wait_for_multiple(m_handles, true, timeout).has_value();
+
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::milliseconds{timeout};
+
+    for (std::size_t begin = 0; begin < m_handles.size(); begin += MAXIMUM_WAIT_OBJECTS) {
+        DWORD remaining = INFINITE;
+        if (timeout != INFINITE) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - clock::now()
+            );
+            remaining = async::to_timeout(left);
+        }
+
+        const auto group = make_group(m_handles, begin, MAXIMUM_WAIT_OBJECTS, NULL);
+        if (!wait_for_multiple(group, true, remaining))
+            return false;
+    }
+    return true;
+}
+
+} // namespace winapi
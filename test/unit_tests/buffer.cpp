@@ -0,0 +1,202 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include <winapi/buffer.hpp>
+#include <winapi/buffer_pool.hpp>
+#include <winapi/chunked_buffer.hpp>
+#include <winapi/uninit_buffer.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace winapi;
+
+BOOST_AUTO_TEST_SUITE(buffer_tests)
+
+BOOST_AUTO_TEST_CASE(resize) {
+    Buffer buffer{"abc", 3};
+    buffer.resize(2);
+    BOOST_TEST(buffer.as_utf8() == "ab");
+    buffer.resize(4);
+    BOOST_TEST(buffer.size() == 4);
+    BOOST_TEST(buffer[2] == 0);
+    BOOST_TEST(buffer[3] == 0);
+    buffer.resize(5, 'x');
+    BOOST_TEST(buffer[4] == 'x');
+}
+
+BOOST_AUTO_TEST_CASE(uninit_buffer) {
+    UninitBuffer buffer{3};
+    BOOST_TEST(buffer.size() == 3);
+    std::memcpy(buffer.data(), "abc", 3);
+
+    // Growing keeps the contents.
+    buffer.resize(1024);
+    BOOST_TEST(buffer.size() == 1024);
+    BOOST_TEST(buffer.capacity() >= 1024);
+    BOOST_TEST(std::memcmp(buffer.data(), "abc", 3) == 0);
+
+    // Shrinking keeps the memory.
+    const auto data = buffer.data();
+    buffer.resize(2);
+    BOOST_TEST(buffer.get().size() == 2);
+    buffer.clear();
+    BOOST_TEST(buffer.empty());
+    buffer.resize(1024);
+    BOOST_TEST(buffer.data() == data);
+
+    UninitBuffer moved{std::move(buffer)};
+    BOOST_TEST(moved.data() == data);
+    BOOST_TEST(buffer.empty());
+    BOOST_TEST(buffer.capacity() == 0);
+}
+
+BOOST_AUTO_TEST_CASE(from_vector) {
+    const std::vector<unsigned char> src{'a', 'b', 'c'};
+    const Buffer buffer{src};
+    BOOST_TEST(buffer.as_utf8() == "abc");
+
+    std::vector<unsigned char> tmp{'d', 'e'};
+    const Buffer moved{std::move(tmp)};
+    BOOST_TEST(moved.as_utf8() == "de");
+    BOOST_TEST(tmp.empty());
+}
+
+BOOST_AUTO_TEST_CASE(views) {
+    const Buffer utf8{"foo", 3};
+    BOOST_TEST(utf8.as_utf8_view() == "foo");
+    BOOST_CHECK_THROW(utf8.as_utf16_view(), std::runtime_error);
+
+    const Buffer utf16{std::wstring_view{L"bar"}};
+    BOOST_TEST((utf16.as_utf16_view() == L"bar"));
+    BOOST_TEST((utf16.as_utf16() == utf16.as_utf16_view()));
+}
+
+BOOST_AUTO_TEST_CASE(span) {
+    struct Record {
+        std::uint16_t a;
+        std::uint16_t b;
+    };
+    const Record records[] = {{1, 2}, {3, 4}};
+    const Buffer buffer{records, sizeof(records)};
+    const auto span = buffer.as_span<Record>();
+    BOOST_TEST(span.size() == 2);
+    BOOST_TEST(span[1].b == 4);
+    const Buffer odd{records, sizeof(records) - sizeof(std::uint16_t)};
+    BOOST_CHECK_THROW(odd.as_span<Record>(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(chunked_empty) {
+    const ChunkedBuffer buffer;
+    BOOST_TEST(buffer.empty());
+    BOOST_TEST(buffer.size() == 0);
+    BOOST_TEST(buffer.chunk_count() == 0);
+    BOOST_TEST(buffer.flatten().empty());
+}
+
+BOOST_AUTO_TEST_CASE(chunked_add) {
+    ChunkedBuffer buffer;
+    buffer.add(Buffer{"foo", 3});
+    buffer.add(Buffer{});
+    buffer.add("bar", 3);
+    buffer.add("baz", 3);
+    BOOST_TEST(buffer.size() == 9);
+    BOOST_TEST(buffer.chunk_count() == 3);
+    BOOST_TEST(buffer.chunk(1).size() == 3);
+
+    std::size_t nb = 0;
+    for (const auto& view : buffer)
+        nb += view.size();
+    BOOST_TEST(nb == buffer.size());
+
+    BOOST_TEST(buffer.flatten().as_utf8() == "foobarbaz");
+
+    const auto chunks = buffer.release();
+    BOOST_TEST(chunks.size() == 3);
+    BOOST_TEST(buffer.empty());
+}
+
+BOOST_AUTO_TEST_CASE(pool_reuse) {
+    BufferPool pool{16};
+    BOOST_TEST(pool.chunk_size() == 16);
+
+    auto buffer = pool.acquire();
+    BOOST_TEST(buffer.empty());
+    BOOST_TEST(buffer.capacity() >= 16);
+    const auto data = buffer.data();
+    buffer.resize(16);
+    pool.release(std::move(buffer));
+
+    const auto reused = pool.acquire();
+    BOOST_TEST(reused.empty());
+    BOOST_TEST(reused.data() == data);
+}
+
+BOOST_AUTO_TEST_CASE(pool_release_grown) {
+    BufferPool pool{16};
+
+    auto buffer = pool.acquire();
+    buffer.resize(1024);
+    const auto data = buffer.data();
+    pool.release(std::move(buffer));
+
+    // It's been grown past the chunk size, so it wasn't kept.
+    const auto fresh = pool.acquire();
+    BOOST_TEST(fresh.data() != data);
+    BOOST_TEST(fresh.capacity() == 16);
+}
+
+BOOST_AUTO_TEST_CASE(pool_switch) {
+    BufferPool pool1{16};
+    BufferPool pool2{32};
+
+    auto buffer1 = pool1.acquire();
+    auto buffer2 = pool2.acquire();
+    const auto data1 = buffer1.data();
+    const auto data2 = buffer2.data();
+
+    // Using another pool on the same thread doesn't drop the cached buffers.
+    pool1.release(std::move(buffer1));
+    pool2.release(std::move(buffer2));
+    BOOST_TEST(pool1.acquire().data() == data1);
+    BOOST_TEST(pool2.acquire().data() == data2);
+}
+
+BOOST_AUTO_TEST_CASE(pool_borrow) {
+    BufferPool pool{16};
+    const unsigned char* data = nullptr;
+    {
+        auto buffer = pool.borrow();
+        BOOST_TEST(buffer.is_borrowed());
+        data = buffer->data();
+    }
+    const auto reused = pool.borrow();
+    BOOST_TEST(reused->data() == data);
+}
+
+BOOST_AUTO_TEST_CASE(pool_threads) {
+    BufferPool pool{16};
+    const auto main = [&pool]() {
+        for (int i = 0; i < 1000; ++i) {
+            auto buffer = pool.borrow();
+            buffer->resize(pool.chunk_size());
+        }
+    };
+    std::thread thread1{main};
+    std::thread thread2{main};
+    thread1.join();
+    thread2.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
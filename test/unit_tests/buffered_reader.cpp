@@ -0,0 +1,66 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include <winapi/buffered_reader.hpp>
+#include <winapi/pipe.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using winapi::BufferedReader;
+using winapi::Pipe;
+
+namespace {
+
+std::vector<std::string> read_lines(const std::string& input, std::size_t chunk_size) {
+    Pipe pipe;
+    std::thread writer{[&pipe, &input]() {
+        pipe.write_end().write(input);
+        pipe.write_end().close();
+    }};
+
+    std::vector<std::string> lines;
+    BufferedReader reader{pipe.read_end(), chunk_size};
+    reader.for_each_line([&lines](std::string_view line) { lines.emplace_back(line); });
+    writer.join();
+    return lines;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(buffered_reader_tests)
+
+BOOST_AUTO_TEST_CASE(lines) {
+    const std::string long_line(1000, 'x');
+    const std::vector<std::string> expected{"a", "bb", "", long_line, "last"};
+
+    // Make lines span chunk boundaries.
+    for (const std::size_t chunk_size : {1, 3, 16, 17, 16 * 1024}) {
+        const auto actual = read_lines("a\r\nbb\n\n" + long_line + "\r\nlast", chunk_size);
+        BOOST_TEST(actual == expected, boost::test_tools::per_element());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(empty) {
+    BOOST_TEST(read_lines("", 16).empty());
+    BOOST_TEST(read_lines("\n", 16).size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(trailing_cr) {
+    // Not followed by a \n, so it's not a terminator.
+    for (const std::size_t chunk_size : {1, 16}) {
+        const std::vector<std::string> expected{"a", "b\r"};
+        const auto actual = read_lines("a\r\nb\r", chunk_size);
+        BOOST_TEST(actual == expected, boost::test_tools::per_element());
+    }
+    BOOST_TEST(read_lines("\r", 16) == std::vector<std::string>{"\r"});
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,113 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "fixtures.hpp"
+
+#include <winapi/buffer.hpp>
+#include <winapi/buffered_writer.hpp>
+#include <winapi/pipe.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <windows.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using winapi::Buffer;
+using winapi::BufferedWriter;
+using winapi::Pipe;
+
+BOOST_AUTO_TEST_SUITE(buffered_writer_tests)
+
+BOOST_AUTO_TEST_CASE(small_writes) {
+    static constexpr std::size_t numof_records = 10000;
+
+    std::string expected;
+    Pipe pipe;
+    Buffer actual;
+    std::thread reader{[&pipe, &actual]() { actual = pipe.read_end().read(); }};
+
+    {
+        BufferedWriter writer{pipe.write_end(), 1024};
+        for (std::size_t i = 0; i < numof_records; ++i) {
+            const auto record = std::to_string(i) + '\n';
+            expected += record;
+            writer.write(record);
+            BOOST_TEST(writer.buffered() < writer.buffer_size());
+        }
+    }
+    pipe.write_end().close();
+    reader.join();
+
+    BOOST_TEST(actual.as_utf8() == expected);
+}
+
+BOOST_AUTO_TEST_CASE(large_write) {
+    std::string expected;
+    Pipe pipe;
+    Buffer actual;
+    std::thread reader{[&pipe, &actual]() { actual = pipe.read_end().read(); }};
+
+    {
+        BufferedWriter writer{pipe.write_end(), 16};
+        const std::string small{"small"};
+        const std::string large(100, 'x');
+        writer.write(small);
+        BOOST_TEST(writer.buffered() == small.size());
+        // Flushes the small write first, then bypasses the buffer.
+        writer.write(large);
+        BOOST_TEST(writer.buffered() == 0);
+        writer.write(small);
+        writer.flush();
+        BOOST_TEST(writer.buffered() == 0);
+        expected = small + large + small;
+    }
+    pipe.write_end().close();
+    reader.join();
+
+    BOOST_TEST(actual.as_utf8() == expected);
+}
+
+BOOST_AUTO_TEST_CASE(partial_write) {
+    Pipe pipe{4096};
+    // Make writes to a full pipe return immediately.
+    DWORD mode = PIPE_NOWAIT;
+    BOOST_TEST(::SetNamedPipeHandleState(pipe.write_end().get(), &mode, NULL, NULL));
+
+    // Way more than the pipe can hold.
+    const auto expected = make_test_data(1024 * 1024);
+    BufferedWriter writer{pipe.write_end(), expected.size() + 1};
+    writer.write(expected);
+    BOOST_TEST(writer.buffered() == expected.size());
+
+    BOOST_CHECK_THROW(writer.flush(), std::runtime_error);
+    // Only the data that's been written is dropped.
+    BOOST_TEST(writer.buffered() > 0);
+    BOOST_TEST(writer.buffered() < expected.size());
+
+    // Make some room in the pipe & retry until everything's written.
+    Buffer actual;
+    Buffer chunk;
+    while (true) {
+        pipe.read_end().read_chunk(chunk);
+        actual.add(chunk);
+        try {
+            writer.flush();
+            break;
+        } catch (const std::runtime_error&) {
+        }
+    }
+    BOOST_TEST(writer.buffered() == 0);
+    pipe.write_end().close();
+    actual.add(pipe.read_end().read());
+
+    BOOST_TEST(actual.size() == expected.size());
+    BOOST_TEST((actual == expected));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 // Distributed under the MIT License.
 
 #include <winapi/cmd_line.hpp>
+#include <winapi/utf8.hpp>
 
 // clang-format off
 // The order matters for older Boost versions.
@@ -75,6 +76,32 @@ BOOST_AUTO_TEST_CASE(to_string) {
     BOOST_TEST(cmd_line.to_string() == expected);
 }
 
+BOOST_AUTO_TEST_CASE(to_wstring) {
+    const std::vector<std::wstring> argv{
+        L"test.exe",
+        L"arg1 arg2",
+        LR"(path\to\dir\)",
+    };
+    const CommandLine cmd_line{argv};
+    const auto expected = LR"("test.exe" "arg1 arg2" "path\to\dir\\")";
+    BOOST_TEST((cmd_line.to_wstring() == expected));
+    BOOST_TEST(cmd_line.to_string() == narrow(expected));
+    BOOST_TEST((CommandLine::parse(cmd_line.to_wstring()).get_wargs() == cmd_line.get_wargs()));
+}
+
+BOOST_AUTO_TEST_CASE(parse_non_ascii) {
+    // Long enough to go through the vectorized ASCII path before hitting the
+    // non-ASCII characters.
+    const std::vector<std::string> argv{
+        "test.exe",
+        std::string(100, 'a') + "\xd1\x82\xd0\xb5\xd1\x81\xd1\x82" + std::string(40, 'b'),
+        "\xe2\x82\xac",
+    };
+    const CommandLine cmd_line{argv};
+    const auto actual = CommandLine::parse(cmd_line.to_string()).get_argv();
+    BOOST_TEST(actual == argv, "actual: " << actual);
+}
+
 BOOST_DATA_TEST_CASE(
     msdn_parse,
     boost::unit_test::data::make(msdn_string) ^ msdn_argv,
@@ -0,0 +1,140 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "fixtures.hpp"
+
+#include <winapi/buffer.hpp>
+#include <winapi/coro.hpp>
+#include <winapi/file.hpp>
+#include <winapi/cmd_line.hpp>
+#include <winapi/handle.hpp>
+#include <winapi/io_completion_port.hpp>
+#include <winapi/path.hpp>
+#include <winapi/process.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+
+using namespace winapi;
+
+namespace {
+
+coro::Task<int> answer() {
+    co_return 42;
+}
+
+coro::Task<int> add_answers() {
+    const auto a = co_await answer();
+    const auto b = co_await answer();
+    co_return a + b;
+}
+
+coro::Task<void> fail() {
+    co_await answer();
+    throw std::runtime_error{"fail"};
+}
+
+coro::Task<Buffer> read_file(const File& file) {
+    Buffer result;
+    std::uint64_t offset = 0;
+    while (true) {
+        const auto chunk = co_await file.async_read_chunk(Handle::max_chunk_size, offset);
+        if (chunk.empty())
+            break;
+        result.add(chunk);
+        offset += chunk.size();
+    }
+    co_return result;
+}
+
+coro::Task<std::size_t> write_halves(const File& file, const Buffer& data) {
+    const auto half = data.size() / 2;
+    auto nb = co_await file.async_write(Buffer{data.data(), half}, 0);
+    nb += co_await file.async_write(Buffer{data.data() + half, data.size() - half}, half);
+    co_return nb;
+}
+
+coro::Task<std::thread::id> resume_on(IoCompletionPort& port) {
+    co_await coro::schedule(port);
+    co_return std::this_thread::get_id();
+}
+
+coro::Task<int> wait_for_exit(const Process& process) {
+    co_return co_await process.exited();
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(coro_tests)
+
+BOOST_AUTO_TEST_CASE(task) {
+    BOOST_TEST(coro::sync_wait(add_answers()) == 84);
+    BOOST_CHECK_THROW(coro::sync_wait(fail()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(async_read_chunk) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    const auto expected = make_test_data(3 * Handle::max_chunk_size + 123);
+    File::open_w(path).write(expected);
+
+    const auto file = File::open_r_async(path);
+    const auto actual = coro::sync_wait(read_file(file));
+    BOOST_TEST(actual.size() == expected.size());
+    BOOST_TEST((actual == expected));
+}
+
+BOOST_AUTO_TEST_CASE(async_write) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    const auto expected = make_test_data(3 * Handle::max_chunk_size + 123);
+    {
+        const auto file = File::open_w_async(path);
+        BOOST_TEST(coro::sync_wait(write_halves(file, expected)) == expected.size());
+    }
+
+    const auto actual = File::open_r(path).read_all();
+    BOOST_TEST(actual.size() == expected.size());
+    BOOST_TEST((actual == expected));
+}
+
+BOOST_AUTO_TEST_CASE(schedule) {
+    IoCompletionPort port{1};
+    const auto worker_id = coro::sync_wait(resume_on(port));
+    port.stop();
+    BOOST_TEST((worker_id != std::this_thread::get_id()));
+}
+
+BOOST_AUTO_TEST_CASE(sync_wait_other_thread) {
+    // The task finishes on a worker, racing the waiting thread.
+    IoCompletionPort port{4};
+    for (int i = 0; i < 1000; ++i)
+        BOOST_TEST((coro::sync_wait(resume_on(port)) != std::this_thread::get_id()));
+    port.stop();
+}
+
+BOOST_FIXTURE_TEST_CASE(process_exited, WithEchoExe) {
+    const auto process = Process::create(CommandLine{get_echo_exe()});
+
+    // echo.exe is stuck trying to read stdin, so the coroutine has to wait.
+    std::thread terminator{[&process]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds{500});
+        process.terminate(123);
+    }};
+    const auto ec = coro::sync_wait(wait_for_exit(process));
+    terminator.join();
+
+    BOOST_TEST(ec == 123);
+    BOOST_TEST(!process.is_running());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,136 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include <winapi/directory.hpp>
+#include <winapi/file.hpp>
+#include <winapi/path.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <set>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace winapi;
+
+namespace {
+
+// test_dir
+// |-- a
+// |   |-- b
+// |   |   `-- file1 (3 bytes)
+// |   `-- link (hard link to file2)
+// `-- file2 (5 bytes)
+class TestTree {
+public:
+    TestTree() {
+        std::filesystem::remove_all(root);
+        std::filesystem::create_directories(root / "a" / "b");
+        std::ofstream{root / "a" / "b" / "file1"} << "123";
+        std::ofstream{root / "file2"} << "12345";
+        std::filesystem::create_hard_link(root / "file2", root / "a" / "link");
+    }
+
+    ~TestTree() {
+        std::error_code ec;
+        std::filesystem::remove_all(root, ec);
+    }
+
+    TestTree(const TestTree&) = delete;
+    TestTree& operator=(const TestTree&) = delete;
+
+    inline static const std::filesystem::path root{"test_dir"};
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(directory_tests)
+
+BOOST_AUTO_TEST_CASE(iterator) {
+    const TestTree tree;
+
+    std::set<std::string> names;
+    auto it = DirectoryIterator::open(CanonicalPath{TestTree::root.wstring()});
+    it.for_each([&names](const DirEntry& entry) {
+        names.emplace(entry.get_name());
+        if (entry.get_name() == "a")
+            BOOST_TEST(entry.is_directory());
+        if (entry.get_name() == "file2") {
+            BOOST_TEST(!entry.is_directory());
+            BOOST_TEST(entry.size == 5);
+        }
+    });
+    BOOST_TEST((names == std::set<std::string>{"a", "file2"}));
+}
+
+BOOST_AUTO_TEST_CASE(iterator_matches_query_id) {
+    const TestTree tree;
+
+    auto it = DirectoryIterator::open(CanonicalPath{TestTree::root.wstring()});
+    while (const auto entry = it.next()) {
+        if (entry->get_name() != "file2")
+            continue;
+        const CanonicalPath path{(TestTree::root / "file2").wstring()};
+        const auto file = File::open_read_attributes(path);
+        BOOST_TEST((entry->id == file.query_id()));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(walker) {
+    const TestTree tree;
+
+    std::mutex mtx;
+    std::set<std::string> names;
+    std::size_t total_size = 0;
+
+    const DirectoryWalker walker{4};
+    const CanonicalPath root{TestTree::root.wstring()};
+    walker.walk(root, [&](const std::wstring&, const DirEntry& entry) {
+        std::lock_guard<std::mutex> lck{mtx};
+        names.emplace(entry.get_name());
+        if (!entry.is_directory())
+            total_size += entry.size;
+    });
+
+    // file2 & link are the same file, reported once.
+    BOOST_TEST(names.size() == 4);
+    BOOST_TEST(names.count("a") == 1);
+    BOOST_TEST(names.count("b") == 1);
+    BOOST_TEST(names.count("file1") == 1);
+    BOOST_TEST(total_size == 3 + 5);
+}
+
+BOOST_AUTO_TEST_CASE(walker_error) {
+    const DirectoryWalker walker{4};
+    const CanonicalPath root{TestTree::root.wstring()};
+    // Subdirectories are only enumerated after their parent, so "a" is gone
+    // by the time it's opened.
+    const auto remove_a = [](const std::wstring&, const DirEntry& entry) {
+        if (entry.get_name() == "a")
+            std::filesystem::remove_all(TestTree::root / "a");
+    };
+
+    {
+        const TestTree tree;
+        BOOST_CHECK_THROW(walker.walk(root, remove_a), std::system_error);
+    }
+
+    const TestTree tree;
+    std::mutex mtx;
+    std::vector<std::wstring> failed;
+    walker.walk(root, remove_a, [&](const std::wstring& dir, const std::system_error&) {
+        std::lock_guard<std::mutex> lck{mtx};
+        failed.emplace_back(dir);
+    });
+    BOOST_TEST(failed.size() == 1);
+    BOOST_TEST((std::filesystem::path{failed[0]}.filename() == "a"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,378 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "fixtures.hpp"
+
+#include <winapi/aligned_buffer.hpp>
+#include <winapi/async_io.hpp>
+#include <winapi/buffer.hpp>
+#include <winapi/file.hpp>
+#include <winapi/path.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <windows.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+using namespace winapi;
+
+BOOST_AUTO_TEST_SUITE(file_tests)
+
+BOOST_AUTO_TEST_CASE(read_all) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    // Make it span multiple chunks.
+    const auto expected = make_test_data(3 * Handle::max_chunk_size + 123);
+    File::open_w(path).write(expected);
+
+    const auto file = File::open_r(path);
+    const auto actual = file.read_all();
+    BOOST_TEST(actual.size() == expected.size());
+    BOOST_TEST((actual == expected));
+}
+
+BOOST_AUTO_TEST_CASE(read_all_empty) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    File::open_w(path);
+    BOOST_TEST(File::open_r(path).read_all().empty());
+}
+
+BOOST_AUTO_TEST_CASE(kind) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    const auto file = File::open_w(path);
+    BOOST_TEST((file.kind() == Handle::Kind::Disk));
+    BOOST_TEST(file.get_chunk_size().is_adaptive());
+}
+
+BOOST_AUTO_TEST_CASE(async_read_write) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    const auto expected = make_test_data(2 * Handle::max_chunk_size);
+    const Buffer first{expected.data(), Handle::max_chunk_size};
+    const Buffer second{expected.data() + Handle::max_chunk_size, Handle::max_chunk_size};
+
+    {
+        const auto file = File::open_w_async(path);
+        // Keep both writes in flight at the same time.
+        auto write2 = file.async_write(second, Handle::max_chunk_size);
+        auto write1 = file.async_write(first, 0);
+        BOOST_TEST(write1.wait() == first.size());
+        BOOST_TEST(write2.wait() == second.size());
+    }
+
+    const auto file = File::open_r_async(path);
+    auto read = file.async_read(expected.size() + 1, 0);
+    BOOST_TEST(read.wait() == expected.size());
+    BOOST_TEST(!read.is_eof());
+    BOOST_TEST((read.buffer() == expected));
+
+    auto eof = file.async_read(Handle::max_chunk_size, expected.size());
+    BOOST_TEST(eof.wait() == 0);
+    BOOST_TEST(eof.is_eof());
+}
+
+BOOST_AUTO_TEST_CASE(map_r) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    const auto expected = make_test_data(256 * 1024 + 123);
+    File::open_w(path).write(expected);
+
+    {
+        const auto view = File::map_r(path);
+        BOOST_TEST(view.size() == expected.size());
+        BOOST_TEST(std::memcmp(view.data(), expected.data(), expected.size()) == 0);
+        view.prefetch();
+    }
+
+    {
+        // Not aligned to the allocation granularity.
+        static constexpr std::size_t offset = 70000;
+        static constexpr std::size_t nb = 1000;
+
+        const auto file = File::open_r(path);
+        const auto view = file.map_r(offset, nb);
+        BOOST_TEST(view.size() == nb);
+        BOOST_TEST(std::memcmp(view.data(), expected.data() + offset, nb) == 0);
+        BOOST_CHECK_THROW(file.map_r(expected.size() - 1, 2), std::range_error);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(map_r_empty) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    File::open_w(path);
+    BOOST_TEST(File::map_r(path).empty());
+}
+
+BOOST_AUTO_TEST_CASE(open_no_buffering) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    std::size_t sector_size = 0;
+    AlignedBuffer expected;
+    {
+        const auto file = File::open(path, File::OpenOptions::write().no_buffering());
+        sector_size = file.get_sector_size();
+        BOOST_TEST(sector_size > 0);
+        BOOST_TEST(AlignedBuffer::alignment % sector_size == 0);
+
+        expected = AlignedBuffer{AlignedBuffer::round_up(3 * sector_size + 1, sector_size)};
+        BOOST_TEST(expected.size() % sector_size == 0);
+        fill_test_data(expected.data(), expected.size());
+        file.write(expected.data(), expected.size());
+    }
+
+    const auto file = File::open(path, File::OpenOptions::read().sequential_scan());
+    const auto actual = file.read_all();
+    BOOST_TEST(actual.size() == expected.size());
+    BOOST_TEST(std::memcmp(actual.data(), expected.data(), expected.size()) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(open_delete_on_close) {
+    static const CanonicalPath path{"test.bin"};
+
+    {
+        auto options = File::OpenOptions::write().temporary().delete_on_close();
+        options.inheritable(false);
+        const auto file = File::open(path, options);
+        file.write(make_test_data(100));
+    }
+    BOOST_CHECK_THROW(File::open_r(path), std::system_error);
+}
+
+BOOST_AUTO_TEST_CASE(stat_many) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    File::open_w(path).write(make_test_data(123));
+
+    // Make it span multiple blocks of paths.
+    std::vector<std::string> paths;
+    for (std::size_t i = 0; i < 1000; ++i)
+        paths.emplace_back(i % 2 ? path.get() : path.get() + ".missing");
+
+    const auto stats = File::stat_many(paths, 4);
+    BOOST_TEST(stats.size() == paths.size());
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        if (i % 2) {
+            BOOST_TEST(stats.is_ok(i));
+            BOOST_TEST(stats.sizes[i] == 123);
+            BOOST_TEST(stats.last_write_times[i] > 0);
+            BOOST_TEST((stats.attributes[i] & FILE_ATTRIBUTE_DIRECTORY) == 0);
+        } else {
+            BOOST_TEST(stats.errors[i] == static_cast<DWORD>(ERROR_FILE_NOT_FOUND));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(reserve_set_size) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    const auto file = File::open_w(path);
+    file.reserve(1024 * 1024);
+    BOOST_TEST(file.get_size() == 0);
+    file.set_size(1000);
+    BOOST_TEST(file.get_size() == 1000);
+    // Extended one way or the other, depending on the privileges.
+    file.set_size_fast(2000);
+    BOOST_TEST(file.get_size() == 2000);
+    file.set_size(10);
+    BOOST_TEST(file.get_size() == 10);
+}
+
+BOOST_AUTO_TEST_CASE(set_size_fast_no_extend) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    const auto file = File::open_w(path);
+    file.set_size(1000);
+    // Shrinking & keeping the size fall back to set_size().
+    BOOST_TEST(!file.set_size_fast(1000));
+    BOOST_TEST(file.get_size() == 1000);
+    BOOST_TEST(!file.set_size_fast(10));
+    BOOST_TEST(file.get_size() == 10);
+}
+
+BOOST_AUTO_TEST_CASE(zero_range) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    static constexpr std::size_t offset = 64 * 1024;
+    static constexpr std::size_t nb = 128 * 1024;
+
+    auto expected = make_test_data(4 * nb);
+    {
+        const auto file = File::open_w(path);
+        file.write(expected);
+        file.set_sparse();
+        file.zero_range(offset, nb);
+    }
+    std::memset(expected.data() + offset, 0, nb);
+
+    const auto actual = File::open_r(path).read_all();
+    BOOST_TEST((actual == expected));
+}
+
+BOOST_AUTO_TEST_CASE(read_at_write_at) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    static constexpr std::size_t numof_threads = 4;
+    static constexpr std::size_t part_size = 100 * 1000;
+
+    const auto expected = make_test_data(numof_threads * part_size);
+    {
+        const auto file = File::open_w(path);
+        std::vector<std::thread> writers;
+        for (std::size_t i = 0; i < numof_threads; ++i)
+            writers.emplace_back([&file, &expected, i]() {
+                const auto offset = i * part_size;
+                file.write_at(offset, {expected.data() + offset, part_size});
+            });
+        for (auto& writer : writers)
+            writer.join();
+    }
+
+    const auto file = File::open_r(path);
+    Buffer actual;
+    actual.resize(part_size);
+    BOOST_TEST(file.read_at(part_size + 1, actual) == part_size);
+    BOOST_TEST(std::memcmp(actual.data(), expected.data() + part_size + 1, part_size) == 0);
+    // Hits the end of the file.
+    BOOST_TEST(file.read_at(expected.size() - 10, actual) == 10);
+    BOOST_TEST(file.read_at(expected.size() + 10, actual) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(read_at_write_at_overlapped) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    const auto expected = make_test_data(2 * 64 * 1024 + 123);
+    {
+        const auto file = File::open_w_async(path);
+        // Out of order.
+        file.write_at(64 * 1024, {expected.data() + 64 * 1024, expected.size() - 64 * 1024});
+        file.write_at(0, {expected.data(), 64 * 1024});
+    }
+
+    const auto file = File::open_r_async(path);
+    Buffer actual;
+    actual.resize(expected.size() + 10);
+    BOOST_TEST(file.read_at(0, actual) == expected.size());
+    actual.resize(expected.size());
+    BOOST_TEST((actual == expected));
+    BOOST_TEST(file.read_at(expected.size() + 10, actual) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(read_all_parallel) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    // Make it split into a few parts.
+    const auto expected = make_test_data(3 * 4 * 1024 * 1024 + 123);
+    File::open_w(path).write(expected);
+
+    const auto file = File::open_r(path);
+    const auto actual = file.read_all_parallel(4);
+    BOOST_TEST(actual.size() == expected.size());
+    BOOST_TEST((actual == expected));
+    // The parts are read using another handle, so the file position of this
+    // one hasn't moved.
+    BOOST_TEST((file.read_all() == expected));
+
+    File::open_w(path).set_size(0);
+    BOOST_TEST(File::open_r(path).read_all_parallel().empty());
+}
+
+BOOST_AUTO_TEST_CASE(copy) {
+    static const CanonicalPath src{"test.bin"};
+    static const CanonicalPath dst{"test.copy.bin"};
+    const RemoveFileGuard remove_src{src};
+    const RemoveFileGuard remove_dst{dst};
+
+    const auto expected = make_test_data(10 * 64 * 1024 + 123);
+    File::open_w(src).write(expected);
+    // Make sure the destination is truncated.
+    File::open_w(dst).write(make_test_data(2 * expected.size()));
+
+    File::CopyOptions options;
+    options.chunk_size = 64 * 1024;
+    options.queue_depth = 3;
+    options.unbuffered = File::CopyOptions::Unbuffered::Never;
+    std::uint64_t last_copied = 0;
+    options.on_progress = [&last_copied](const File::CopyProgress& progress) {
+        BOOST_TEST(progress.copied >= last_copied);
+        last_copied = progress.copied;
+    };
+
+    const auto progress = File::copy(src, dst, options);
+    BOOST_TEST(progress.copied == expected.size());
+    BOOST_TEST(progress.total == expected.size());
+    BOOST_TEST(last_copied == expected.size());
+    BOOST_TEST((File::open_r(dst).read_all() == expected));
+}
+
+BOOST_AUTO_TEST_CASE(copy_unbuffered) {
+    static const CanonicalPath src{"test.bin"};
+    static const CanonicalPath dst{"test.copy.bin"};
+    const RemoveFileGuard remove_src{src};
+    const RemoveFileGuard remove_dst{dst};
+
+    // Not a multiple of the sector size.
+    const auto expected = make_test_data(3 * 1024 * 1024 + 123);
+    File::open_w(src).write(expected);
+
+    File::CopyOptions options;
+    options.chunk_size = 1024 * 1024;
+    options.unbuffered = File::CopyOptions::Unbuffered::Always;
+
+    const auto progress = File::copy(src, dst, options);
+    BOOST_TEST(progress.copied == expected.size());
+    BOOST_TEST(progress.get_throughput() >= 0);
+    BOOST_TEST((File::open_r(dst).read_all() == expected));
+}
+
+BOOST_AUTO_TEST_CASE(copy_skip_zero_fill) {
+    static const CanonicalPath src{"test.bin"};
+    static const CanonicalPath dst{"test.copy.bin"};
+    const RemoveFileGuard remove_src{src};
+    const RemoveFileGuard remove_dst{dst};
+
+    const auto expected = make_test_data(10 * 64 * 1024 + 123);
+    File::open_w(src).write(expected);
+
+    File::CopyOptions options;
+    options.chunk_size = 64 * 1024;
+    options.unbuffered = File::CopyOptions::Unbuffered::Never;
+    options.skip_zero_fill = true;
+    // More than WaitForMultipleObjects can handle.
+    options.queue_depth = 100;
+
+    // The destination exists & is larger, then of the same size.
+    File::open_w(dst).write(make_test_data(2 * expected.size()));
+    File::copy(src, dst, options);
+    BOOST_TEST((File::open_r(dst).read_all() == expected));
+    File::copy(src, dst, options);
+    BOOST_TEST((File::open_r(dst).read_all() == expected));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -7,17 +7,32 @@
 
 #include "shared/command.hpp"
 
+#include <winapi/buffer.hpp>
 #include <winapi/cmd_line.hpp>
 #include <winapi/file.hpp>
 #include <winapi/path.hpp>
 
 #include <boost/test/unit_test.hpp>
 
+#include <cstddef>
 #include <exception>
 #include <format>
 #include <stdexcept>
 #include <string>
 
+// Fill memory with a pattern that doesn't repeat every power of two bytes.
+inline void fill_test_data(unsigned char* data, std::size_t nb) {
+    for (std::size_t i = 0; i < nb; ++i)
+        data[i] = static_cast<unsigned char>(i % 251);
+}
+
+inline winapi::Buffer make_test_data(std::size_t nb) {
+    winapi::Buffer buffer;
+    buffer.resize(nb);
+    fill_test_data(buffer.data(), buffer.size());
+    return buffer;
+}
+
 class RemoveFileGuard {
 public:
     explicit RemoveFileGuard(const winapi::CanonicalPath& path) : m_path{path} {}
@@ -3,12 +3,29 @@
 // For details, see https://github.com/egor-tensin/winapi-common.
 // Distributed under the MIT License.
 
+#include "fixtures.hpp"
+
+#include <winapi/async_io.hpp>
+#include <winapi/buffer.hpp>
 #include <winapi/handle.hpp>
+#include <winapi/pipe.hpp>
 
 #include <boost/test/unit_test.hpp>
 
 #include <windows.h>
 
+#include <chrono>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using winapi::Buffer;
+using winapi::Handle;
+using winapi::Pipe;
+
 BOOST_AUTO_TEST_SUITE(handle_tests)
 
 BOOST_AUTO_TEST_CASE(null) {
@@ -24,4 +41,217 @@ BOOST_AUTO_TEST_CASE(null) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(kind) {
+    Pipe pipe;
+    BOOST_TEST((pipe.read_end().kind() == Handle::Kind::Pipe));
+    BOOST_TEST((pipe.write_end().kind() == Handle::Kind::Pipe));
+    BOOST_TEST(!pipe.read_end().get_chunk_size().is_adaptive());
+
+    const Handle event{::CreateEventW(NULL, TRUE, FALSE, NULL)};
+    BOOST_TEST((event.kind() == Handle::Kind::Unknown));
+
+    // The kind travels with the handle.
+    const auto read_end = std::move(pipe.read_end());
+    BOOST_TEST((read_end.kind() == Handle::Kind::Pipe));
+}
+
+BOOST_AUTO_TEST_CASE(chunk_size_fixed) {
+    auto chunk_size = Handle::ChunkSize::fixed(100);
+    BOOST_TEST(!chunk_size.is_adaptive());
+    chunk_size.update(100, 100);
+    BOOST_TEST(chunk_size.get() == 100);
+    chunk_size.update(100, 1);
+    BOOST_TEST(chunk_size.get() == 100);
+}
+
+BOOST_AUTO_TEST_CASE(chunk_size_adaptive) {
+    auto chunk_size = Handle::ChunkSize::adaptive(100, 300);
+    BOOST_TEST(chunk_size.is_adaptive());
+    BOOST_TEST(chunk_size.get() == 100);
+    chunk_size.update(100, 100);
+    BOOST_TEST(chunk_size.get() == 200);
+    chunk_size.update(200, 200);
+    BOOST_TEST(chunk_size.get() == 300);
+    chunk_size.update(300, 300);
+    BOOST_TEST(chunk_size.get() == 300);
+    chunk_size.update(300, 10);
+    BOOST_TEST(chunk_size.get() == 150);
+    chunk_size.update(150, 10);
+    BOOST_TEST(chunk_size.get() == 100);
+}
+
+BOOST_AUTO_TEST_CASE(chunk_size_per_handle) {
+    Pipe pipe;
+    pipe.read_end().set_chunk_size(Handle::ChunkSize::adaptive(100, 400));
+    pipe.write_end().write(make_test_data(1000));
+
+    // The policy carries over between reads from the same handle.
+    Buffer chunk;
+    BOOST_TEST(pipe.read_end().read_chunk(chunk));
+    BOOST_TEST(chunk.size() == 100);
+    BOOST_TEST(pipe.read_end().get_chunk_size().get() == 200);
+    BOOST_TEST(pipe.read_end().read_chunk(chunk));
+    BOOST_TEST(chunk.size() == 200);
+    BOOST_TEST(pipe.read_end().get_chunk_size().get() == 400);
+
+    // Explicit policies don't affect it.
+    auto chunk_size = Handle::ChunkSize::adaptive(100, 400);
+    BOOST_TEST(pipe.read_end().read_chunk(chunk, chunk_size));
+    BOOST_TEST(chunk.size() == 100);
+    BOOST_TEST(pipe.read_end().get_chunk_size().get() == 400);
+
+    // Setting a policy starts over.
+    pipe.read_end().set_chunk_size(Handle::ChunkSize::adaptive(100, 400));
+    BOOST_TEST(pipe.read_end().get_chunk_size().get() == 100);
+}
+
+BOOST_AUTO_TEST_CASE(read_adaptive) {
+    const auto expected = make_test_data(1024 * 1024 + 123);
+
+    Pipe pipe{64 * 1024};
+    std::thread writer{[&pipe, &expected]() {
+        pipe.write_end().write(expected);
+        pipe.write_end().close();
+    }};
+    const auto actual = pipe.read_end().read(Handle::ChunkSize::adaptive());
+    writer.join();
+
+    BOOST_TEST(actual.size() == expected.size());
+    BOOST_TEST((actual == expected));
+}
+
+BOOST_AUTO_TEST_CASE(read_chunked_clamped) {
+    const auto expected = make_test_data(1000);
+
+    Pipe pipe;
+    pipe.read_end().set_chunk_size(Handle::ChunkSize::adaptive(100, 400));
+    std::thread writer{[&pipe, &expected]() {
+        // A short read first, so that the next one is clamped to what's left
+        // of the first chunk.
+        pipe.write_end().write(expected.data(), 50);
+        DWORD available = 1;
+        while (available != 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+            ::PeekNamedPipe(pipe.read_end().get(), NULL, 0, NULL, &available, NULL);
+        }
+        pipe.write_end().write(expected.data() + 50, expected.size() - 50);
+        pipe.write_end().close();
+    }};
+    const auto actual = pipe.read_end().read_chunked();
+    writer.join();
+
+    BOOST_TEST((actual.flatten() == expected));
+    // The clamped read came back full, but mustn't have grown the policy.
+    BOOST_TEST(actual.chunk_count() >= 2);
+    BOOST_TEST(actual.chunk(0).size() == 100);
+    BOOST_TEST(actual.chunk(1).size() == 100);
+}
+
+BOOST_AUTO_TEST_CASE(read_each) {
+    const auto expected = make_test_data(10 * Handle::max_chunk_size + 123);
+
+    Pipe pipe;
+    std::thread writer{[&pipe, &expected]() {
+        pipe.write_end().write(expected);
+        pipe.write_end().close();
+    }};
+    Buffer actual;
+    std::size_t numof_chunks = 0;
+    pipe.read_end().read_each([&](std::span<const unsigned char> chunk) {
+        BOOST_TEST(chunk.size() <= Handle::max_chunk_size);
+        actual.add(Buffer{chunk.data(), chunk.size()});
+        ++numof_chunks;
+    });
+    writer.join();
+
+    BOOST_TEST(numof_chunks >= 11);
+    BOOST_TEST((actual == expected));
+}
+
+BOOST_AUTO_TEST_CASE(write_gather) {
+    // Small pieces are coalesced, the large one is written directly.
+    const auto header = make_test_data(10);
+    const auto payload = make_test_data(Handle::max_gather_size + 1);
+    const auto trailer = make_test_data(20);
+
+    Buffer expected;
+    expected.add(header);
+    expected.add(payload);
+    expected.add(trailer);
+    expected.add(header);
+
+    const std::vector<std::span<const std::byte>> pieces{
+        std::as_bytes(std::span{header}),
+        std::as_bytes(std::span{payload}),
+        std::as_bytes(std::span{trailer}),
+        std::as_bytes(std::span{header}),
+    };
+
+    Pipe pipe{64 * 1024};
+    std::thread writer{[&pipe, &pieces]() {
+        pipe.write_end().write(pieces);
+        pipe.write_end().close();
+    }};
+    const auto actual = pipe.read_end().read();
+    writer.join();
+
+    BOOST_TEST(actual.size() == expected.size());
+    BOOST_TEST((actual == expected));
+}
+
+BOOST_AUTO_TEST_CASE(write_text) {
+    // Only consoles get the special treatment.
+    const std::string expected{"a\xd0\xb6" "b"};
+
+    Pipe pipe;
+    pipe.write_end().write_text(expected);
+    pipe.write_end().close();
+    BOOST_TEST(pipe.read_end().read().as_utf8() == expected);
+}
+
+BOOST_AUTO_TEST_CASE(async_cancel) {
+    const auto pipe = Pipe::overlapped();
+
+    HANDLE event = NULL;
+    {
+        // Nothing's been written, so the read is pending until it's cancelled.
+        const auto read = pipe.read_end().async_read();
+        event = read.event();
+        BOOST_TEST(!read.is_ready());
+    }
+
+    // The event of the abandoned read is reused.
+    auto read = pipe.read_end().async_read();
+    BOOST_TEST(read.event() == event);
+    BOOST_TEST(!read.wait_for(std::chrono::milliseconds{10}));
+    read.cancel();
+    BOOST_TEST(read.is_ready());
+    BOOST_TEST(read.get_size() == 0);
+}
+
+#ifdef WINAPI_COMMON_IO_STATS
+BOOST_AUTO_TEST_CASE(io_stats) {
+    const auto expected = make_test_data(100);
+
+    Pipe pipe;
+    BOOST_TEST(pipe.read_end().get_io_stats().reads == 0);
+    pipe.write_end().write(expected);
+    pipe.write_end().close();
+    const auto actual = pipe.read_end().read();
+    BOOST_TEST((actual == expected));
+
+    const auto stats = pipe.read_end().get_io_stats();
+    // The last read hits the end of the pipe.
+    BOOST_TEST(stats.reads >= 2);
+    BOOST_TEST(stats.bytes_read == expected.size());
+    BOOST_TEST(stats.short_reads >= 1);
+    BOOST_TEST(stats.writes == 0);
+    BOOST_TEST(winapi::IoStats::global().snapshot().bytes_written >= expected.size());
+
+    // The statistics travel with the handle.
+    const auto write_end = std::move(pipe.write_end());
+    BOOST_TEST(write_end.get_io_stats().bytes_written == expected.size());
+}
+#endif
+
 BOOST_AUTO_TEST_SUITE_END()
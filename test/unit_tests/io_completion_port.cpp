@@ -0,0 +1,144 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "fixtures.hpp"
+
+#include <winapi/buffer.hpp>
+#include <winapi/handle.hpp>
+#include <winapi/io_completion_port.hpp>
+#include <winapi/pipe.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <windows.h>
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+using winapi::Buffer;
+using winapi::Handle;
+using winapi::IoCompletionPort;
+using winapi::Pipe;
+
+BOOST_AUTO_TEST_SUITE(io_completion_port_tests)
+
+BOOST_AUTO_TEST_CASE(post) {
+    static constexpr std::size_t numof_tasks = 100;
+
+    std::atomic<std::size_t> counter{0};
+    {
+        IoCompletionPort port{4};
+        BOOST_TEST(port.thread_count() == 4);
+        for (std::size_t i = 0; i < numof_tasks; ++i)
+            port.post([&counter]() { ++counter; });
+        port.stop();
+        BOOST_TEST(port.pending() == 0);
+    }
+    BOOST_TEST(counter.load() == numof_tasks);
+}
+
+BOOST_AUTO_TEST_CASE(read_pipe) {
+    const auto expected = make_test_data(3 * Handle::max_chunk_size + 123);
+
+    IoCompletionPort port{2};
+    auto pipe = Pipe::overlapped();
+    port.associate(pipe.read_end());
+
+    // Only a single read is in flight at a time, so no locking is required.
+    Buffer actual;
+    DWORD error = ERROR_SUCCESS;
+    std::promise<void> done;
+
+    std::function<void(IoCompletionPort::Result)> on_read;
+    on_read = [&](IoCompletionPort::Result result) {
+        if (!result.is_ok()) {
+            error = result.error;
+            done.set_value();
+            return;
+        }
+        actual.add(result.buffer);
+        port.async_read(pipe.read_end(), Handle::max_chunk_size, on_read);
+    };
+    port.async_read(pipe.read_end(), Handle::max_chunk_size, on_read);
+
+    std::thread writer{[&pipe, &expected]() {
+        pipe.write_end().write(expected);
+        pipe.write_end().close();
+    }};
+    done.get_future().wait();
+    writer.join();
+    port.stop();
+
+    BOOST_TEST(error == static_cast<DWORD>(ERROR_BROKEN_PIPE));
+    BOOST_TEST(actual.size() == expected.size());
+    BOOST_TEST((actual == expected));
+}
+
+BOOST_AUTO_TEST_CASE(stop_cancels_reads) {
+    IoCompletionPort port{1};
+    auto pipe = Pipe::overlapped();
+    port.associate(pipe.read_end());
+
+    // Nothing is ever written, so the read would never complete by itself.
+    DWORD error = ERROR_SUCCESS;
+    port.async_read(pipe.read_end(), Handle::max_chunk_size, [&error](auto result) {
+        error = result.error;
+    });
+    port.stop();
+
+    BOOST_TEST(port.pending() == 0);
+    BOOST_TEST(error == static_cast<DWORD>(ERROR_OPERATION_ABORTED));
+}
+
+BOOST_AUTO_TEST_CASE(stop_rethrows) {
+    std::atomic<std::size_t> counter{0};
+    IoCompletionPort port{2};
+    port.post([]() { throw std::runtime_error{"first"}; });
+    for (std::size_t i = 0; i < 10; ++i)
+        port.post([&counter]() { ++counter; });
+
+    // The workers survive exceptions.
+    BOOST_CHECK_THROW(port.stop(), std::runtime_error);
+    BOOST_TEST(counter.load() == 10);
+    BOOST_TEST(port.pending() == 0);
+    // The exception is only rethrown once.
+    port.stop();
+}
+
+BOOST_AUTO_TEST_CASE(stop_from_worker) {
+    IoCompletionPort port{2};
+    std::promise<bool> thrown;
+    port.post([&port, &thrown]() {
+        try {
+            port.stop();
+            thrown.set_value(false);
+        } catch (const std::runtime_error&) {
+            thrown.set_value(true);
+        }
+    });
+    BOOST_TEST(thrown.get_future().get());
+    port.stop();
+}
+
+BOOST_AUTO_TEST_CASE(rejects_after_stop) {
+    IoCompletionPort port{1};
+    auto pipe = Pipe::overlapped();
+    port.associate(pipe.read_end());
+    port.stop();
+
+    const auto ignore = [](IoCompletionPort::Result) {};
+    BOOST_CHECK_THROW(port.post([]() {}), std::runtime_error);
+    BOOST_CHECK_THROW(
+        port.async_read(pipe.read_end(), Handle::max_chunk_size, ignore), std::runtime_error
+    );
+    BOOST_CHECK_THROW(port.async_write(pipe.write_end(), Buffer{}, ignore), std::runtime_error);
+    BOOST_TEST(port.pending() == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "fixtures.hpp"
+
+#include <winapi/async_io.hpp>
+#include <winapi/buffer.hpp>
+#include <winapi/file.hpp>
+#include <winapi/io_stats.hpp>
+#include <winapi/path.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+
+using namespace winapi;
+
+BOOST_AUTO_TEST_SUITE(io_stats_tests)
+
+BOOST_AUTO_TEST_CASE(bucket) {
+    using std::chrono::microseconds;
+    using std::chrono::nanoseconds;
+    using std::chrono::seconds;
+
+    BOOST_TEST(IoStats::bucket(nanoseconds{0}) == 0);
+    BOOST_TEST(IoStats::bucket(nanoseconds{999}) == 0);
+    BOOST_TEST(IoStats::bucket(microseconds{1}) == 1);
+    BOOST_TEST(IoStats::bucket(microseconds{2}) == 2);
+    BOOST_TEST(IoStats::bucket(microseconds{3}) == 2);
+    BOOST_TEST(IoStats::bucket(microseconds{1024}) == 11);
+    BOOST_TEST(IoStats::bucket(seconds{1000000}) == IoStats::numof_buckets - 1);
+}
+
+BOOST_AUTO_TEST_CASE(record) {
+    using std::chrono::microseconds;
+
+    IoStats stats;
+    stats.record_read(100, 100, microseconds{1});
+    stats.record_read(100, 10, microseconds{5});
+    stats.record_write(50, microseconds{0});
+
+    auto snapshot = stats.snapshot();
+    BOOST_TEST(snapshot.reads == 2);
+    BOOST_TEST(snapshot.bytes_read == 110);
+    BOOST_TEST(snapshot.short_reads == 1);
+    BOOST_TEST(snapshot.read_latency[1] == 1);
+    BOOST_TEST(snapshot.read_latency[3] == 1);
+    BOOST_TEST(snapshot.writes == 1);
+    BOOST_TEST(snapshot.bytes_written == 50);
+    BOOST_TEST(snapshot.write_latency[0] == 1);
+
+    stats.reset();
+    snapshot = stats.snapshot();
+    BOOST_TEST(snapshot.reads == 0);
+    BOOST_TEST(snapshot.read_latency[1] == 0);
+}
+
+#ifdef WINAPI_COMMON_IO_STATS
+
+BOOST_AUTO_TEST_CASE(positional) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    const auto data = make_test_data(1000);
+    File::open_w(path).write_at(0, data);
+
+    const auto file = File::open_r(path);
+    Buffer actual;
+    actual.resize(2 * data.size());
+    BOOST_TEST(file.read_at(0, actual) == data.size());
+
+    const auto snapshot = file.get_io_stats();
+    BOOST_TEST(snapshot.reads == 1);
+    BOOST_TEST(snapshot.bytes_read == data.size());
+    BOOST_TEST(snapshot.short_reads == 1);
+    BOOST_TEST(snapshot.writes == 0);
+}
+
+BOOST_AUTO_TEST_CASE(overlapped) {
+    static const CanonicalPath path{"test.bin"};
+    const RemoveFileGuard remove_file{path};
+
+    const auto data = make_test_data(1000);
+    const auto before = IoStats::global().snapshot();
+    {
+        const auto file = File::open_w_async(path);
+        BOOST_TEST(file.async_write(data, 0).wait() == data.size());
+    }
+    {
+        const auto file = File::open_r_async(path);
+        BOOST_TEST(file.async_read(data.size(), 0).wait() == data.size());
+    }
+    const auto after = IoStats::global().snapshot();
+
+    BOOST_TEST(after.reads - before.reads == 1);
+    BOOST_TEST(after.bytes_read - before.bytes_read == data.size());
+    BOOST_TEST(after.writes - before.writes == 1);
+    BOOST_TEST(after.bytes_written - before.bytes_written == data.size());
+}
+
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -5,6 +5,7 @@
 
 #include "fixtures.hpp"
 
+#include <winapi/buffer.hpp>
 #include <winapi/cmd_line.hpp>
 #include <winapi/file.hpp>
 #include <winapi/path.hpp>
@@ -16,6 +17,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <chrono>
+#include <span>
 #include <thread>
 #include <utility>
 
@@ -49,6 +51,47 @@ BOOST_FIXTURE_TEST_CASE(echo_stdout_to_pipe, WithEchoExe) {
     BOOST_TEST(stdout8 == "aaa\r\nbbb\r\nccc\r\n");
 }
 
+BOOST_FIXTURE_TEST_CASE(echo_stdout_to_pipe_chunked, WithEchoExe) {
+    const CommandLine cmd_line{get_echo_exe(), {"aaa", "bbb", "ccc"}};
+    process::IO io;
+    Pipe stdout_pipe;
+    io.std_out = Stdout{stdout_pipe};
+    const auto process = Process::create(cmd_line, std::move(io));
+    const auto stdout16 = stdout_pipe.read_end().read_chunked();
+    process.wait();
+    BOOST_TEST(process.get_exit_code() == 0);
+    const auto stdout8 = narrow(stdout16.flatten());
+    BOOST_TEST(stdout8 == "aaa\r\nbbb\r\nccc\r\n");
+}
+
+BOOST_FIXTURE_TEST_CASE(echo_stdout_to_pipe_view, WithEchoExe) {
+    const CommandLine cmd_line{get_echo_exe(), {"aaa", "bbb", "ccc"}};
+    process::IO io;
+    Pipe stdout_pipe;
+    io.std_out = Stdout{stdout_pipe};
+    const auto process = Process::create(cmd_line, std::move(io));
+    const auto stdout16 = stdout_pipe.read_end().read();
+    process.wait();
+    BOOST_TEST(process.get_exit_code() == 0);
+    // Look at the output without copying it.
+    const auto view = stdout16.as_utf16_view();
+    BOOST_TEST((view == L"aaa\r\nbbb\r\nccc\r\n"));
+    BOOST_TEST(view.data() == reinterpret_cast<const wchar_t*>(stdout16.data()));
+}
+
+BOOST_FIXTURE_TEST_CASE(echo_stdout_read_each, WithEchoExe) {
+    const CommandLine cmd_line{get_echo_exe(), {"aaa", "bbb", "ccc"}};
+    Buffer stdout16;
+    const auto on_stdout = [&stdout16](std::span<const unsigned char> chunk) {
+        // A chunk might end in the middle of a character.
+        stdout16.add(Buffer{chunk.data(), chunk.size()});
+    };
+    const auto ec = Process::read_each_stdout(cmd_line, on_stdout);
+    BOOST_TEST(ec == 0);
+    const auto stdout8 = narrow(stdout16);
+    BOOST_TEST(stdout8 == "aaa\r\nbbb\r\nccc\r\n");
+}
+
 BOOST_FIXTURE_TEST_CASE(echo_stdout_to_file, WithEchoExe) {
     static const CanonicalPath stdout_path{"test.txt"};
     const RemoveFileGuard remove_stdout_file{stdout_path};
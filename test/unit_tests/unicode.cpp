@@ -0,0 +1,127 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include "unicode.hpp"
+
+#include <boost/test/data/monomorphic.hpp>
+#include <boost/test/data/test_case.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+using winapi::unicode::Kernel;
+
+namespace winapi::unicode {
+
+std::ostream& operator<<(std::ostream& os, Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Scalar:
+            return os << "Scalar";
+        case Kernel::SSE2:
+            return os << "SSE2";
+        case Kernel::AVX2:
+            return os << "AVX2";
+    }
+    return os << "Unknown";
+}
+
+} // namespace winapi::unicode
+
+namespace {
+
+const std::vector<Kernel> kernels{Kernel::Scalar, Kernel::SSE2, Kernel::AVX2};
+
+// Covers the 16- & 32-character blocks, as well as the tails after them.
+constexpr std::size_t max_length = 2 * 32 + 17;
+
+std::string make_ascii(std::size_t nch) {
+    std::string result;
+    for (std::size_t i = 0; i < nch; ++i)
+        result += static_cast<char>('!' + i % 90);
+    return result;
+}
+
+std::vector<std::uint16_t> to_utf16(const std::string& src) {
+    return {src.cbegin(), src.cend()};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(unicode_tests)
+
+BOOST_DATA_TEST_CASE(widen_ascii, kernels, kernel) {
+    if (!winapi::unicode::is_supported(kernel))
+        return;
+
+    for (std::size_t nch = 0; nch <= max_length; ++nch) {
+        auto src = make_ascii(nch);
+        const auto expected = to_utf16(src);
+
+        std::vector<std::uint16_t> dest(nch + 1, 0xffff);
+        BOOST_TEST(winapi::unicode::widen_ascii(kernel, src.data(), nch, dest.data()) == nch);
+        BOOST_TEST((std::vector<std::uint16_t>{dest.cbegin(), dest.cbegin() + nch} == expected));
+        // Nothing is written past the end.
+        BOOST_TEST(dest[nch] == 0xffff);
+
+        // Stop at the first non-ASCII byte, wherever it is.
+        for (std::size_t pos = 0; pos < nch; ++pos) {
+            auto non_ascii = src;
+            non_ascii[pos] = static_cast<char>(0xc3);
+            const auto n = winapi::unicode::widen_ascii(kernel, non_ascii.data(), nch, dest.data());
+            BOOST_TEST(n == pos, "length " << nch << ", non-ASCII at " << pos);
+            BOOST_TEST((std::vector<std::uint16_t>{dest.cbegin(), dest.cbegin() + n} ==
+                        std::vector<std::uint16_t>{expected.cbegin(), expected.cbegin() + n}));
+        }
+    }
+}
+
+BOOST_DATA_TEST_CASE(narrow_ascii, kernels, kernel) {
+    if (!winapi::unicode::is_supported(kernel))
+        return;
+
+    for (std::size_t nch = 0; nch <= max_length; ++nch) {
+        const auto expected = make_ascii(nch);
+        auto src = to_utf16(expected);
+
+        std::string dest(nch + 1, '\xff');
+        BOOST_TEST(winapi::unicode::narrow_ascii(kernel, src.data(), nch, dest.data()) == nch);
+        BOOST_TEST(dest.substr(0, nch) == expected);
+        // Nothing is written past the end.
+        BOOST_TEST(dest[nch] == '\xff');
+
+        // Stop at the first non-ASCII code unit, wherever it is; these are
+        // just above the ASCII range, in the Latin-1 range & above it.
+        for (const std::uint16_t c : {0x80, 0xff, 0x100, 0xff80}) {
+            for (std::size_t pos = 0; pos < nch; ++pos) {
+                auto non_ascii = src;
+                non_ascii[pos] = c;
+                const auto n =
+                    winapi::unicode::narrow_ascii(kernel, non_ascii.data(), nch, dest.data());
+                BOOST_TEST(n == pos, "length " << nch << ", non-ASCII at " << pos);
+                BOOST_TEST(dest.substr(0, n) == expected.substr(0, n));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(round_trip) {
+    // The non-ASCII remainder is converted separately, wherever it starts.
+    for (std::size_t nch = 0; nch <= max_length; ++nch) {
+        for (std::size_t pos = 0; pos <= nch; ++pos) {
+            auto utf8 = make_ascii(nch);
+            utf8.insert(pos, "\xd0\xb6");
+            const auto utf16 = winapi::unicode::widen(utf8);
+            BOOST_TEST(utf16.size() == nch + 1);
+            BOOST_TEST((utf16[pos] == L'\x0436'));
+            BOOST_TEST(winapi::unicode::narrow(utf16) == utf8);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
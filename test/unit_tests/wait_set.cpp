@@ -0,0 +1,168 @@
+// Copyright (c) 2020 Egor Tensin <Egor.Tensin@gmail.com>
+// This file is part of the "winapi-common" project.
+// For details, see https://github.com/egor-tensin/winapi-common.
+// Distributed under the MIT License.
+
+#include <winapi/handle.hpp>
+#include <winapi/wait_set.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+using winapi::Handle;
+using winapi::WaitSet;
+
+namespace {
+
+std::vector<Handle> make_events(std::size_t n, bool manual_reset = true) {
+    std::vector<Handle> events;
+    for (std::size_t i = 0; i < n; ++i)
+        events.emplace_back(::CreateEventW(NULL, manual_reset, FALSE, NULL));
+    return events;
+}
+
+WaitSet make_wait_set(const std::vector<Handle>& handles) {
+    WaitSet wait_set;
+    for (const auto& handle : handles)
+        wait_set.add(handle);
+    return wait_set;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(wait_set_tests)
+
+BOOST_AUTO_TEST_CASE(wait_any) {
+    // Exceed MAXIMUM_WAIT_OBJECTS.
+    for (const std::size_t n : {10, 200}) {
+        const auto events = make_events(n);
+        const auto wait_set = make_wait_set(events);
+
+        BOOST_TEST(!wait_set.wait_any(std::chrono::milliseconds{10}));
+
+        const std::size_t index = n * 3 / 4;
+        ::SetEvent(events[index].get());
+        BOOST_TEST(wait_set.wait_any() == index);
+        BOOST_TEST(*wait_set.wait_any(std::chrono::milliseconds{0}) == index);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(wait_any_many_signalled) {
+    // Objects that stay signalled are never lost, whichever group reports
+    // first.
+    static constexpr std::size_t n = 200;
+    const auto events = make_events(n);
+    const auto wait_set = make_wait_set(events);
+
+    const std::vector<std::size_t> signalled{0, 70, 130, 199};
+    for (const auto index : signalled)
+        ::SetEvent(events[index].get());
+
+    for (std::size_t i = 0; i < 10; ++i) {
+        const auto index = wait_set.wait_any();
+        BOOST_TEST((std::find(signalled.begin(), signalled.end(), index) != signalled.end()));
+    }
+    for (const auto index : signalled)
+        BOOST_TEST(::WaitForSingleObject(events[index].get(), 0) == WAIT_OBJECT_0);
+}
+
+BOOST_AUTO_TEST_CASE(wait_any_auto_reset) {
+    // Small sets don't need helpers, so any object is fine.
+    const Handle event{::CreateEventW(NULL, FALSE, FALSE, NULL)};
+    const auto events = make_events(10);
+    auto wait_set = make_wait_set(events);
+    const auto index = wait_set.add(event);
+
+    ::SetEvent(event.get());
+    BOOST_TEST(wait_set.wait_any() == index);
+    // It's been consumed by the wait.
+    BOOST_TEST(!wait_set.wait_any(std::chrono::milliseconds{0}));
+}
+
+BOOST_AUTO_TEST_CASE(wait_any_many_auto_reset) {
+    // Every signal is reported exactly once, even though the helpers wait
+    // for the objects too.
+    static constexpr std::size_t n = 200;
+    const auto events = make_events(n, false);
+    const auto wait_set = make_wait_set(events);
+
+    std::vector<std::size_t> signalled{10, 100, 190};
+    for (const auto index : signalled)
+        ::SetEvent(events[index].get());
+
+    std::vector<std::size_t> reported;
+    for (std::size_t i = 0; i < signalled.size(); ++i) {
+        const auto index = wait_set.wait_any(std::chrono::seconds{1});
+        BOOST_TEST(index.has_value());
+        if (index)
+            reported.emplace_back(*index);
+    }
+    std::sort(reported.begin(), reported.end());
+    BOOST_TEST(reported == signalled);
+    BOOST_TEST(!wait_set.wait_any(std::chrono::milliseconds{10}));
+}
+
+BOOST_AUTO_TEST_CASE(wait_any_many_semaphore_mutex) {
+    auto events = make_events(200);
+    auto wait_set = make_wait_set(events);
+
+    const Handle semaphore{::CreateSemaphoreW(NULL, 2, 2, NULL)};
+    const auto semaphore_index = wait_set.add(semaphore);
+    BOOST_TEST(wait_set.wait_any() == semaphore_index);
+    BOOST_TEST(wait_set.wait_any() == semaphore_index);
+    BOOST_TEST(!wait_set.wait_any(std::chrono::milliseconds{10}));
+    BOOST_TEST(::ReleaseSemaphore(semaphore.get(), 2, NULL));
+
+    // The mutex is owned by the calling thread, not one of the helpers.
+    const Handle mutex{::CreateMutexW(NULL, FALSE, NULL)};
+    wait_set.remove(semaphore_index);
+    const auto mutex_index = wait_set.add(mutex);
+    BOOST_TEST(wait_set.wait_any() == mutex_index);
+    BOOST_TEST(::ReleaseMutex(mutex.get()));
+}
+
+BOOST_AUTO_TEST_CASE(wait_any_many_changed) {
+    // The helpers are restarted when the set changes.
+    const auto events = make_events(200);
+    auto wait_set = make_wait_set(events);
+    BOOST_TEST(!wait_set.wait_any(std::chrono::milliseconds{10}));
+
+    const Handle event{::CreateEventW(NULL, TRUE, TRUE, NULL)};
+    const auto index = wait_set.add(event);
+    BOOST_TEST(wait_set.wait_any() == index);
+
+    const auto copy = wait_set;
+    BOOST_TEST(copy.wait_any() == index);
+}
+
+BOOST_AUTO_TEST_CASE(wait_all) {
+    for (const std::size_t n : {10, 200}) {
+        const auto events = make_events(n);
+        const auto wait_set = make_wait_set(events);
+
+        for (std::size_t i = 0; i + 1 < n; ++i)
+            ::SetEvent(events[i].get());
+        BOOST_TEST(!wait_set.wait_all(std::chrono::milliseconds{10}));
+
+        ::SetEvent(events[n - 1].get());
+        BOOST_TEST(wait_set.wait_all(std::chrono::milliseconds{0}));
+        wait_set.wait_all();
+    }
+}
+
+BOOST_AUTO_TEST_CASE(remove) {
+    const auto events = make_events(3);
+    auto wait_set = make_wait_set(events);
+    ::SetEvent(events[0].get());
+    wait_set.remove(0);
+    BOOST_TEST(wait_set.size() == 2);
+    BOOST_TEST(!wait_set.wait_any(std::chrono::milliseconds{0}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()